@@ -0,0 +1,30 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "bench_alloc.h"
+
+/* every heap allocation of the process is counted, to report allocations per row */
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {free(p);}
+void operator delete[](void* p) noexcept {free(p);}
+void operator delete(void* p, size_t) noexcept {operator delete(p);}
+void operator delete[](void* p, size_t) noexcept {operator delete[](p);}
+
+size_t mparsers_bench::allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,16 @@
+#ifndef M_BENCH_ALLOC_HEADER
+#define M_BENCH_ALLOC_HEADER
+
+#include <cstddef>
+
+namespace mparsers_bench
+{
+    /** \brief number of heap allocations of the process so far.
+     * operator new is replaced in its own translation unit: inlined next to the code using it, its malloc and
+     * the free of operator delete would be reported as mismatched by -Wmismatched-new-delete.
+     */
+    size_t allocation_count();
+
+} /* namespace mparsers_bench */
+
+#endif // M_BENCH_ALLOC_HEADER
@@ -0,0 +1,74 @@
+#include <fstream>
+#include <random>
+#include "bench_data.h"
+
+namespace mparsers_bench
+{
+    std::string command_name(int idx)
+    {
+        return "CMD_" + std::to_string(idx);
+    }
+
+    static void random_field(std::mt19937& rng, int width, std::string& out)
+    {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-.";
+        for(int it=0; it < width; ++it)
+            out += alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+
+    size_t generate_csv(const std::string& fn, const csv_shape_t& shape)
+    {
+        std::ofstream ofs(fn, std::ofstream::out | std::ofstream::binary);
+        std::mt19937 rng(shape.seed);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::string line;
+        size_t written = 0;
+        while(written < shape.bytes)
+        {
+            line.clear();
+            if(coin(rng) < shape.comment_density / 2)
+            {
+                line += "# ";
+                random_field(rng, shape.field_width * 2, line);
+            }
+            else
+            {
+                for(int c=0; c < shape.columns; ++c)
+                {
+                    if(c)
+                        line += ';';
+                    random_field(rng, shape.field_width, line);
+                }
+                if(coin(rng) < shape.comment_density / 2)
+                {
+                    line += " # ";
+                    random_field(rng, shape.field_width, line);
+                }
+            }
+            line += '\n';
+            ofs.write(line.data(), line.size());
+            written += line.size();
+        }
+        return written;
+    }
+
+    size_t generate_assignments(const std::string& fn, const assign_shape_t& shape)
+    {
+        std::ofstream ofs(fn, std::ofstream::out | std::ofstream::binary);
+        std::mt19937 rng(shape.seed);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::string line;
+        size_t written = 0;
+        while(written < shape.bytes)
+        {
+            if(coin(rng) < shape.comment_density)
+                line = "# some comment line\n";
+            else
+                line = command_name(rng() % shape.commands) + " = ETH 1 0 " + std::to_string(rng() % 100)
+                     + " 15    ; trailing comment\n";
+            ofs.write(line.data(), line.size());
+            written += line.size();
+        }
+        return written;
+    }
+} /* namespace mparsers_bench */
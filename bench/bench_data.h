@@ -0,0 +1,50 @@
+#ifndef M_BENCH_DATA_HEADER
+#define M_BENCH_DATA_HEADER
+
+#include <string>
+#include <cstddef>
+
+namespace mparsers_bench
+{
+    /** \brief shape of a generated csv file
+     */
+    struct csv_shape_t
+    {
+        size_t  bytes;              //!< approximate file size
+        int     columns;            //!< columns per row
+        int     field_width;        //!< characters per field
+        double  comment_density;    //!< ratio of lines which are comments, or carry a trailing comment
+        unsigned seed;              //!< random generator seed
+    };
+
+    /** \brief shape of a generated assignment file
+     */
+    struct assign_shape_t
+    {
+        size_t  bytes;              //!< approximate file size
+        int     commands;           //!< number of distinct commands
+        double  comment_density;    //!< ratio of comment lines
+        unsigned seed;              //!< random generator seed
+    };
+
+    /** \brief write a ';' separated, '#' commented csv file
+     * \param [in] filename: output file
+     * \param [in] shape: file shape
+     * \return number of bytes written
+     */
+    size_t generate_csv(const std::string& filename, const csv_shape_t& shape);
+
+    /** \brief write an assignment file, commands are named CMD_0 .. CMD_<commands-1>
+     * \param [in] filename: output file
+     * \param [in] shape: file shape
+     * \return number of bytes written
+     */
+    size_t generate_assignments(const std::string& filename, const assign_shape_t& shape);
+
+    /** \brief name of the idx-th generated command
+     */
+    std::string command_name(int idx);
+
+} /* namespace mparsers_bench */
+
+#endif // M_BENCH_DATA_HEADER
@@ -0,0 +1,546 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+#include <libmparsers.h>
+#include "bench_alloc.h"
+#include "bench_data.h"
+
+using namespace mparsers;
+using namespace mparsers_bench;
+
+namespace
+{
+    /** \brief benchmark settings, filled from the command line
+     */
+    struct options_t
+    {
+        size_t          csv_bytes;
+        int             columns;
+        int             field_width;
+        double          comment_density;
+        int             commands;
+        int             repeat;
+        int             threads;
+        bool            json;
+        std::string     filter;
+        std::string     dir;
+
+        options_t():
+              csv_bytes(64 << 20)
+            , columns(12)
+            , field_width(8)
+            , comment_density(0.1)
+            , commands(1000)
+            , repeat(3)
+            , threads(0)
+            , json(false)
+            , filter()
+            , dir("/tmp")
+        {}
+    };
+
+    /** \brief best run of one benchmark
+     */
+    struct result_t
+    {
+        std::string name;       //!< benchmark name
+        double      seconds;    //!< best wall time
+        size_t      bytes;      //!< bytes processed per run
+        size_t      rows;       //!< rows (or calls) processed per run
+        size_t      allocs;     //!< heap allocations of the best run
+    };
+
+    std::vector<result_t> results;
+    options_t options;
+    volatile size_t sink;       //!< keeps benchmarked results alive
+
+    /* run fn (returning the number of rows it processed) options.repeat times, keep the fastest run */
+    template <class fn_t>
+    void run(const std::string& name, size_t bytes, fn_t&& fn)
+    {
+        if(!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            return;
+        result_t best = {name, 0.0, bytes, 0, 0};
+        for(int it=0; it < options.repeat; ++it)
+        {
+            const size_t allocs_before = allocation_count();
+            const auto start = std::chrono::steady_clock::now();
+            const size_t rows = fn();
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const size_t allocs = allocation_count() - allocs_before;
+            if(!it || elapsed < best.seconds)
+            {
+                best.seconds = elapsed;
+                best.rows = rows;
+                best.allocs = allocs;
+            }
+        }
+        results.push_back(best);
+        if(!options.json)
+            std::cerr << "done: " << name << std::endl;
+    }
+
+    void print_table()
+    {
+        std::cout << std::left << std::setw(32) << "benchmark" << std::right
+                  << std::setw(12) << "MB/s" << std::setw(16) << "rows/s" << std::setw(14) << "allocs/row"
+                  << std::setw(12) << "seconds" << "\n";
+        for(const auto& r : results)
+        {
+            std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed
+                      << std::setw(12) << std::setprecision(1) << (r.bytes / r.seconds / (1 << 20))
+                      << std::setw(16) << std::setprecision(0) << (r.rows / r.seconds)
+                      << std::setw(14) << std::setprecision(3) << (r.rows ? (double)r.allocs / r.rows : 0.0)
+                      << std::setw(12) << std::setprecision(4) << r.seconds << "\n";
+        }
+    }
+
+    void print_json()
+    {
+        std::cout << "{\n  \"csv_bytes\": " << options.csv_bytes << ", \"columns\": " << options.columns
+                  << ", \"field_width\": " << options.field_width << ", \"comment_density\": " << options.comment_density
+                  << ", \"commands\": " << options.commands << ", \"simd_level\": " << (int)simd_level()
+                  << ",\n  \"results\": [";
+        for(size_t it=0; it < results.size(); ++it)
+        {
+            const result_t& r = results[it];
+            std::cout << (it ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"seconds\": " << r.seconds
+                      << ", \"bytes\": " << r.bytes << ", \"rows\": " << r.rows << ", \"allocs\": " << r.allocs
+                      << ", \"mb_per_s\": " << (r.bytes / r.seconds / (1 << 20))
+                      << ", \"rows_per_s\": " << (r.rows / r.seconds)
+                      << ", \"allocs_per_row\": " << (r.rows ? (double)r.allocs / r.rows : 0.0) << "}";
+        }
+        std::cout << "\n  ]\n}\n";
+    }
+
+    void usage(const char* prog)
+    {
+        std::cerr << "usage: " << prog << " [options]\n"
+                  << "  --size MB          csv file size (64)\n"
+                  << "  --columns N        csv columns (12)\n"
+                  << "  --width N          csv field width (8)\n"
+                  << "  --comments RATIO   comment density, 0..1 (0.1)\n"
+                  << "  --commands N       distinct commands of the assignment file (1000)\n"
+                  << "  --repeat N         runs per benchmark, the fastest is kept (3)\n"
+                  << "  --threads N        threads of the parallel benchmarks, 0 for all (0)\n"
+                  << "  --filter TEXT      only run benchmarks whose name contains TEXT\n"
+                  << "  --dir PATH         where to generate input files (/tmp)\n"
+                  << "  --json             machine readable output\n"
+                  << "exits with status 2 when each_row or rows allocate per row once warmed up\n";
+    }
+
+    bool parse_args(int argc, char** argv)
+    {
+        for(int it=1; it < argc; ++it)
+        {
+            const std::string arg = argv[it];
+            const bool has_value = it + 1 < argc;
+            if(arg == "--json")
+                options.json = true;
+            else if(arg == "--size" && has_value)
+                options.csv_bytes = (size_t)(atof(argv[++it]) * (1 << 20));
+            else if(arg == "--columns" && has_value)
+                options.columns = atoi(argv[++it]);
+            else if(arg == "--width" && has_value)
+                options.field_width = atoi(argv[++it]);
+            else if(arg == "--comments" && has_value)
+                options.comment_density = atof(argv[++it]);
+            else if(arg == "--commands" && has_value)
+                options.commands = atoi(argv[++it]);
+            else if(arg == "--repeat" && has_value)
+                options.repeat = atoi(argv[++it]);
+            else if(arg == "--threads" && has_value)
+                options.threads = atoi(argv[++it]);
+            else if(arg == "--filter" && has_value)
+                options.filter = argv[++it];
+            else if(arg == "--dir" && has_value)
+                options.dir = argv[++it];
+            else
+                return false;
+        }
+        return options.repeat > 0 && options.columns > 0 && options.commands > 0;
+    }
+
+    /* allocations of a parse run once the parser row is warmed up by a first run: fn() returns the rows it read */
+    template <class fn_t>
+    size_t steady_allocations(fn_t&& fn, size_t& rows)
+    {
+        fn();
+        const size_t before = allocation_count();
+        rows = fn();
+        return allocation_count() - before;
+    }
+
+    /* each_row and rows reuse the storage of their row: after a first parse, a parse may only allocate its
+     * fixed setup (input buffers, callback), never per row. Returns false, after reporting it, otherwise */
+    bool check_steady_allocations(generic_csv_parser_t& parser, const std::string& fn)
+    {
+        bool ok = true;
+        auto check = [&ok](const char* name, size_t allocs, size_t rows)
+        {
+            const size_t max_allocations = 16;
+            if(allocs <= max_allocations)
+                return;
+            std::cerr << "self check failed: " << name << " made " << allocs << " allocations for " << rows
+                      << " rows after warm-up\n";
+            ok = false;
+        };
+        size_t rows = 0;
+        size_t allocs = steady_allocations([&]
+        {
+            size_t count = 0;
+            parser.each_row(fn, [&count](const generic_csv_parser_t::row_t&, int){count++;});
+            return count;
+        }, rows);
+        check("each_row", allocs, rows);
+        allocs = steady_allocations([&]
+        {
+            size_t count = 0;
+            for(const generic_csv_parser_t::row_t& row : parser.rows(fn))
+                count += !row.empty();
+            return count;
+        }, rows);
+        check("rows", allocs, rows);
+        return ok;
+    }
+
+    bool csv_benchmarks()
+    {
+        const std::string fn = options.dir + "/mparsers_bench.csv";
+        const size_t bytes = generate_csv(fn, csv_shape_t{options.csv_bytes, options.columns, options.field_width
+                                                         , options.comment_density, 42});
+        generic_csv_parser_t parser(options.columns);
+        const bool steady = check_steady_allocations(parser, fn);
+
+        run("csv/each_row", bytes, [&]
+        {
+            size_t fields = 0;
+            parser.each_row(fn, [&fields](const generic_csv_parser_t::row_t& row, int)
+            {
+                fields += row.size();
+            });
+            return fields / options.columns;
+        });
+
+        run("csv/rows", bytes, [&]
+        {
+            size_t fields = 0;
+            for(const generic_csv_parser_t::row_t& row : parser.rows(fn))
+                fields += row.size();
+            return fields / options.columns;
+        });
+
+        run("csv/each_row_stats", bytes, [&]
+        {
+            typedef csv_parser_t<';','#',untyped_t,0,collect_stats_t> counted_parser_t;
+            counted_parser_t counted(options.columns);
+            size_t fields = 0;
+            counted.each_row(fn, [&fields](const counted_parser_t::row_t& row, int)
+            {
+                fields += row.size();
+            });
+            return (size_t)counted.stats().rows;
+        });
+
+        run("csv/each_row_projected", bytes, [&]
+        {
+            size_t kept = 0;
+            parser.set_projection({1, options.columns - 1}, 0, [](std::string_view key)
+            {
+                return !key.empty() && key[0] < 'a';
+            });
+            parser.each_row(fn, [&kept](const generic_csv_parser_t::row_t& row, int)
+            {
+                kept += row.size();
+            });
+            parser.clear_projection();
+            sink = kept;
+            return (size_t)parser.lineno;
+        });
+
+        run("csv/each_row_sampled", bytes, [&]
+        {
+            size_t kept = 0;
+            parser.set_sampling(1, 0.01, 42);
+            parser.each_row(fn, [&kept](const generic_csv_parser_t::row_t& row, int)
+            {
+                kept += row.size();
+            });
+            parser.clear_limits();
+            sink = kept;
+            return (size_t)parser.lineno;
+        });
+
+        run("csv/each_view_row_stoppable", bytes, [&]
+        {
+            size_t kept = 0;
+            parser.each_view_row(fn, [&kept](const generic_csv_parser_t::view_row_t& row, int)
+            {
+                kept += row.size();
+                return row[0] == "stop";
+            });
+            sink = kept;
+            return (size_t)parser.lineno;
+        });
+
+        run("csv/each_view_row", bytes, [&]
+        {
+            return (size_t)parser.each_view_row(fn, [](const generic_csv_parser_t::view_row_t&, int){});
+        });
+
+        run("csv/each_view_row_function", bytes, [&]
+        {
+            const std::function<void(const generic_csv_parser_t::view_row_t&, int)> callback
+                = [](const generic_csv_parser_t::view_row_t&, int){};
+            return (size_t)parser.each_view_row(fn, callback);
+        });
+
+        run("csv/each_view_row_batch", bytes, [&]
+        {
+            size_t fields = 0;
+            const int rows = parser.each_view_row_batch(fn, [&fields](const row_batch_t& batch)
+            {
+                fields += batch.fields.size();
+            });
+            sink = fields;
+            return (size_t)rows;
+        });
+
+        run("csv/each_view_row_quoted", bytes, [&]
+        {
+            quoted_csv_parser_t quoted(options.columns);
+            return (size_t)quoted.each_view_row(fn, [](const quoted_csv_parser_t::view_row_t&, int){});
+        });
+
+        run("csv/each_view_row_parallel", bytes, [&]
+        {
+            return (size_t)parser.each_view_row_parallel(fn, [](const generic_csv_parser_t::view_row_t&, int){}
+                                                          , generic_csv_parser_t::UNORDERED, options.threads);
+        });
+
+        run("csv/each_view_row_parallel_ord", bytes, [&]
+        {
+            return (size_t)parser.each_view_row_parallel(fn, [](const generic_csv_parser_t::view_row_t&, int){}
+                                                          , generic_csv_parser_t::IN_ORDER, options.threads);
+        });
+
+        const std::string out = options.dir + "/mparsers_bench_out.csv";
+        const size_t out_rows = bytes / 32;
+        size_t out_bytes = 0;
+        generic_csv_writer_t::buffer_t sample;
+        for(size_t r=0; r < out_rows; ++r)
+        {
+            sample.row((int64_t)r, r * 0.25, "label", r % 97);
+            out_bytes += sample.size();
+            sample.clear();
+        }
+        generic_csv_writer_t writer;
+        run("csv/write_ofstream", out_bytes, [&]
+        {
+            std::ofstream ofs(out);
+            for(size_t r=0; r < out_rows; ++r)
+                ofs << (int64_t)r << ';' << r * 0.25 << ';' << "label" << ';' << r % 97 << '\n';
+            return out_rows;
+        });
+
+        run("csv/write", out_bytes, [&]
+        {
+            writer.open(out);
+            for(size_t r=0; r < out_rows; ++r)
+                writer.row((int64_t)r, r * 0.25, "label", r % 97);
+            writer.close();
+            return out_rows;
+        });
+
+        run("csv/write_parallel", out_bytes, [&]
+        {
+            writer.open(out);
+            writer.write_parallel(out_rows, [](generic_csv_writer_t::buffer_t& buffer, size_t r)
+            {
+                buffer.row((int64_t)r, r * 0.25, "label", r % 97);
+            }, options.threads);
+            writer.close();
+            return out_rows;
+        });
+        remove(out.c_str());
+
+        /* label file: low cardinality status, region and type columns */
+        std::vector<std::string> labels;
+        for(int it=0; it < 56; ++it)
+            labels.push_back((it < 8 ? "status_" : it < 48 ? "region_" : "type_") + std::to_string(it));
+        writer.open(out);
+        for(size_t r=0; r < out_rows; ++r)
+            writer.row((int64_t)r, labels[r % 8], labels[8 + r * 7 % 40], labels[48 + r % 5 % 8], r * 0.25);
+        writer.close();
+        const size_t label_bytes = writer.bytes_written();
+
+        generic_csv_parser_t label_parser(5);
+        run("csv/each_row_group_by", label_bytes, [&]
+        {
+            std::unordered_map<std::string, size_t> counts;
+            label_parser.each_row(out, [&counts](const generic_csv_parser_t::row_t& row, int)
+            {
+                counts[row[2]]++;
+            });
+            return counts.size() ? (size_t)label_parser.lineno : 0;
+        });
+
+        run("csv/each_row_group_by_interned", label_bytes, [&]
+        {
+            std::vector<size_t> counts;
+            label_parser.set_interned_columns({2});
+            label_parser.each_row(out, [&counts](const generic_csv_parser_t::row_t& row, int)
+            {
+                const uint32_t id = row.id(2);
+                if(id >= counts.size())
+                    counts.resize(id + 1);
+                counts[id]++;
+            });
+            label_parser.set_interned_columns({});
+            return counts.size() ? (size_t)label_parser.lineno : 0;
+        });
+        remove(out.c_str());
+
+        std::ifstream ifs(fn);
+        std::vector<std::string> lines;
+        std::string line;
+        size_t line_bytes = 0;
+        while(lines.size() < 100000 && std::getline(ifs, line))
+        {
+            line_bytes += line.size() + 1;
+            lines.push_back(line);
+        }
+
+        run("str/split", line_bytes, [&]
+        {
+            size_t fields = 0;
+            for(const auto& l : lines)
+                fields += split(l, ';').size();
+            sink = fields;
+            return lines.size();
+        });
+
+        run("str/ignore_comment", line_bytes, [&]
+        {
+            size_t kept = 0;
+            for(const auto& l : lines)
+                kept += ignore_comment(l, '#').size();
+            sink = kept;
+            return lines.size();
+        });
+
+        std::vector<char> buffer;
+        run("str/strtrim", line_bytes, [&]
+        {
+            size_t kept = 0;
+            for(const auto& l : lines)
+            {
+                buffer.assign(l.begin(), l.end());
+                buffer.push_back(0);
+                kept += strlen(strtrim(buffer.data()));
+            }
+            sink = kept;
+            return lines.size();
+        });
+
+        run("str/trim_view", line_bytes, [&]
+        {
+            size_t kept = 0;
+            for(const auto& l : lines)
+                kept += trim_view(l).size();
+            sink = kept;
+            return lines.size();
+        });
+
+        run("str/split_view", line_bytes, [&]
+        {
+            size_t fields = 0;
+            for(const auto& l : lines)
+                for(std::string_view part : split_view(l, ';'))
+                    fields += !part.empty();
+            sink = fields;
+            return lines.size();
+        });
+
+        run("str/ignore_comment_view", line_bytes, [&]
+        {
+            size_t kept = 0;
+            for(const auto& l : lines)
+                kept += ignore_comment_view(l, '#').size();
+            sink = kept;
+            return lines.size();
+        });
+        remove(fn.c_str());
+        return steady;
+    }
+
+    void assign_benchmarks()
+    {
+        const std::string fn = options.dir + "/mparsers_bench.cfg";
+        const size_t bytes = generate_assignments(fn, assign_shape_t{options.csv_bytes / 4, options.commands
+                                                                    , options.comment_density, 42});
+        opt_parser_t parser;
+        size_t calls = 0;
+        for(int it=0; it < options.commands; ++it)
+            parser.add_cmd_parser(command_name(it), nullptr, [&calls](const std::string&, char*, void*, int)
+            {
+                calls++;
+                return false;
+            });
+
+        run("opt/parse", bytes, [&]
+        {
+            calls = 0;
+            parser.parse(fn);
+            return calls;
+        });
+
+        /* storing the words of each value: by hand in callbacks, then with typed bindings */
+        std::vector<std::vector<std::string>> values(options.commands);
+        opt_parser_t split_parser;
+        for(int it=0; it < options.commands; ++it)
+            split_parser.add_cmd_parser(command_name(it), &values[it], [](const std::string&, char* value, void* ud, int)
+            {
+                *static_cast<std::vector<std::string>*>(ud) = split(stdstrim(value ? value : ""), ' ');
+                return false;
+            });
+
+        run("opt/parse_split", bytes, [&]
+        {
+            split_parser.parse(fn);
+            return (size_t)split_parser.lineno;
+        });
+
+        opt_parser_t bound_parser;
+        for(int it=0; it < options.commands; ++it)
+            bound_parser.bind(command_name(it), &values[it]);
+
+        run("opt/bind", bytes, [&]
+        {
+            bound_parser.parse(fn);
+            return (size_t)bound_parser.lineno;
+        });
+        remove(fn.c_str());
+    }
+} /* namespace */
+
+int main(int argc, char** argv)
+{
+    if(!parse_args(argc, argv))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    const bool steady = csv_benchmarks();
+    assign_benchmarks();
+    if(options.json)
+        print_json();
+    else
+        print_table();
+    return steady ? 0 : 2;
+}
@@ -1,11 +1,23 @@
-#ifndef LIBMPARSERS_H_INCLUDED
-#define LIBMPARSERS_H_INCLUDED
-
-
-#include <parsers/mstring_utils.h>
-#include <parsers/var_assign_parser.h>
-#include <parsers/csv_parser.h>
-
-#define HAVE_LIB_M_PARSERS
-
-#endif // LIBMPARSERS_H_INCLUDED
+#ifndef LIBMPARSERS_H_INCLUDED
+#define LIBMPARSERS_H_INCLUDED
+
+
+#include <parsers/mstring_utils.h>
+#include <parsers/char_scan.h>
+#include <parsers/mapped_file.h>
+#include <parsers/block_reader.h>
+#include <parsers/compressed_source.h>
+#include <parsers/parse_stats.h>
+#include <parsers/line_index.h>
+#include <parsers/string_pool.h>
+#include <parsers/thread_pool.h>
+#include <parsers/csv_schema.h>
+#include <parsers/column_table.h>
+#include <parsers/var_assign_parser.h>
+#include <parsers/opt_watcher.h>
+#include <parsers/csv_parser.h>
+#include <parsers/csv_writer.h>
+
+#define HAVE_LIB_M_PARSERS
+
+#endif // LIBMPARSERS_H_INCLUDED
@@ -0,0 +1,153 @@
+#ifndef M_BLOCK_READER_HEADER
+#define M_BLOCK_READER_HEADER
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file block_reader.h
+ * \brief large block reads, split into lines of any length
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief where a block_reader_t gets its bytes from
+ */
+struct input_source_t
+{
+    virtual ~input_source_t() {}
+
+    /**
+    * \brief read up to size bytes
+    * \param [out] buffer: destination
+    * \param [in] size: room in buffer
+    * \return number of bytes read, 0 at end of input
+    */
+    virtual size_t read(char* buffer, size_t size) = 0;
+};
+
+/**
+ * \brief reads an already opened std::istream
+ */
+struct stream_source_t : public input_source_t
+{
+    explicit stream_source_t(std::istream& in): input(in) {}
+    size_t read(char* buffer, size_t size) override;
+
+private:
+    std::istream& input;    //!< input stream
+};
+
+/**
+ * \brief reads a file with unbuffered large reads
+ */
+struct file_source_t : public input_source_t
+{
+    file_source_t(): file(nullptr) {}
+    ~file_source_t() override;
+
+    /**
+    * \brief open a file
+    * \param [in] filename: file to read
+    * \return true on success
+    */
+    bool open(const std::string& filename);
+
+    /**
+    * \brief move the read position
+    * \param [in] offset: byte offset from the beginning of the file
+    * \return true on success
+    */
+    bool seek(uint64_t offset);
+    size_t read(char* buffer, size_t size) override;
+
+private:
+    FILE* file;     //!< opened file
+
+    file_source_t(const file_source_t&): input_source_t(), file(nullptr) {GO_UNREACHABLE();}
+    const file_source_t& operator=(const file_source_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+ * \brief splits an input into lines, reading it by large blocks.
+ * Lines are returned in place, inside one buffer which rolls forward: only the incomplete line at the end of a
+ * block is moved when the next block is read. The buffer grows when a line is longer than it, so lines can have
+ * any length.
+ */
+struct block_reader_t
+{
+    static const size_t default_block_size = 1 << 20;      //!< 1 MiB
+
+    /**
+    * \param [in,out] src: input, must outlive the reader
+    * \param [in] block_size: initial buffer size, and size of the reads
+    */
+    explicit block_reader_t(input_source_t& src, size_t block_size = default_block_size);
+
+    /**
+    * \brief get the next line. Its end of line is replaced by a null character.
+    * The last line is returned even without end of line, unless it is empty.
+    * \param [out] line: first character of the line, valid until the next call
+    * \param [out] length: line length, without end of line
+    * \return false at end of input
+    */
+    bool next_line(char*& line, size_t& length);
+
+    //!< @brief bytes read from the source so far
+    inline size_t bytes_read() const {return total;}
+    //!< @brief bytes consumed so far, which is the offset of the next line in the input read by the reader
+    inline size_t offset() const {return total - (tail - head);}
+
+private:
+    /**
+    * \brief keep the unconsumed bytes, and read the next block after them
+    * \return false at end of input
+    */
+    bool refill();
+
+    input_source_t&     source;     //!< where bytes come from
+    std::unique_ptr<char[]> buffer; //!< rolling buffer, left uninitialized
+    size_t              capacity;   //!< usable room in buffer, which has one more byte for a terminator
+    size_t              head;       //!< first unconsumed byte
+    size_t              tail;       //!< one past the last read byte
+    size_t              searched;   //!< bytes after head known to have no end of line
+    size_t              total;      //!< bytes read so far
+    bool                eof;        //!< the source is exhausted
+
+    block_reader_t(const block_reader_t& o):
+          source(o.source)
+        , buffer()
+        , capacity(0)
+        , head(0)
+        , tail(0)
+        , searched(0)
+        , total(0)
+        , eof(true)
+    {GO_UNREACHABLE();}
+    const block_reader_t& operator=(const block_reader_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_BLOCK_READER_HEADER
@@ -0,0 +1,415 @@
+#ifndef M_CHAR_SCAN_HEADER
+#define M_CHAR_SCAN_HEADER
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MPARSERS_HAVE_X86_SIMD
+#include <immintrin.h>
+#define MPARSERS_TARGET(__isa) __attribute__((target(__isa)))
+#endif
+
+namespace mparsers
+{
+    /** \defgroup mtools_scan Character scanning
+     * \brief vectorized search of field delimiters, comment starters and end of lines
+     * \{
+     * \file char_scan.h
+     * \brief field boundaries scanning kernels, SSE2/AVX2 with a scalar fallback chosen at runtime
+     * \author Marouane BELAOUCHA
+     */
+
+    /** \brief instruction set used by the scanning kernels
+     */
+    enum simd_level_t
+    {
+        SIMD_SCALAR = 0,    //!< portable byte per byte loop
+        SIMD_SSE2,          //!< 4x16 bytes compares, 64 bytes per step
+        SIMD_AVX2           //!< 2x32 bytes compares, 64 bytes per step
+    };
+
+    /** \brief best instruction set available on the running CPU, detected once
+     * \return the detected level
+     */
+    simd_level_t simd_level();
+
+    /** \brief force the instruction set used by the kernels (testing and benchmarking purpose)
+     * \param [in] level: level to use. It is lowered to what the CPU supports
+     */
+    void set_simd_level(simd_level_t level);
+
+    /** \brief characters searched by scan_fields, known at compile time.
+     * Each instantiation builds its comparison masks from constants.
+     */
+    template <char __delimiter, char __comment_starter, char __newline='\n'>
+    struct static_scan_set_t
+    {
+        static constexpr char delimiter = __delimiter;      //!< field separator
+        static constexpr char comment = __comment_starter;  //!< stops the scan
+        static constexpr char newline = __newline;          //!< stops the scan
+    };
+
+    /** \brief characters searched by scan_fields, known at runtime.
+     * Set comment and newline to delimiter to scan for the delimiter only.
+     */
+    struct scan_set_t
+    {
+        char delimiter;     //!< field separator
+        char comment;       //!< stops the scan
+        char newline;       //!< stops the scan
+    };
+
+    namespace detail
+    {
+        template <class set_t>
+        inline const char* scan_fields_scalar(const char* p, const char* first, const char* last
+                                              , const set_t& set, std::vector<uint32_t>& bounds)
+        {
+            for(; p < last; ++p)
+            {
+                const char c = *p;
+                if(c == set.delimiter)
+                    bounds.push_back(p - first);
+                else if(c == set.comment || c == set.newline)
+                    return p;
+            }
+            return last;
+        }
+
+        /* same as scan_fields_scalar, ignoring delimiters, comment starters and end of lines between quotes */
+        template <class set_t>
+        inline const char* scan_quoted_scalar(const char* p, const char* first, const char* last, const set_t& set
+                                              , char quote, std::vector<uint32_t>& bounds, bool& inside)
+        {
+            for(; p < last; ++p)
+            {
+                const char c = *p;
+                if(c == quote)
+                    inside = !inside;
+                else if(inside)
+                    continue;
+                else if(c == set.delimiter)
+                    bounds.push_back(p - first);
+                else if(c == set.comment || c == set.newline)
+                    return p;
+            }
+            return last;
+        }
+
+        /* bit i of the result is the parity of the bits 0..i of m: set from an opening quote to its closing one */
+        inline uint64_t prefix_xor(uint64_t m)
+        {
+            m ^= m << 1;
+            m ^= m << 2;
+            m ^= m << 4;
+            m ^= m << 8;
+            m ^= m << 16;
+            m ^= m << 32;
+            return m;
+        }
+
+        /* walk a 64 bits match mask: record delimiters, stop at anything else */
+        template <class set_t>
+        inline bool consume_mask(uint64_t mask, const char* p, const char* first
+                                 , const set_t& set, std::vector<uint32_t>& bounds, const char*& stop)
+        {
+            while(mask)
+            {
+                const int i = __builtin_ctzll(mask);
+                if(p[i] != set.delimiter)
+                {
+                    stop = p + i;
+                    return true;
+                }
+                bounds.push_back(p + i - first);
+                mask &= mask - 1;
+            }
+            return false;
+        }
+
+#ifdef MPARSERS_HAVE_X86_SIMD
+        template <class set_t>
+        MPARSERS_TARGET("sse2")
+        inline uint64_t match_mask_sse2(const char* p, const set_t& set)
+        {
+            const __m128i d = _mm_set1_epi8(set.delimiter);
+            const __m128i c = _mm_set1_epi8(set.comment);
+            const __m128i n = _mm_set1_epi8(set.newline);
+            uint64_t mask = 0;
+            for(int k = 0; k < 4; ++k)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16*k));
+                const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, c))
+                                               , _mm_cmpeq_epi8(v, n));
+                mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << (16*k);
+            }
+            return mask;
+        }
+
+        template <class set_t>
+        MPARSERS_TARGET("sse2")
+        const char* scan_fields_sse2(const char* first, const char* last
+                                     , const set_t& set, std::vector<uint32_t>& bounds)
+        {
+            const char* p = first;
+            const char* stop = last;
+            for(; p + 64 <= last; p += 64)
+                if(consume_mask(match_mask_sse2(p, set), p, first, set, bounds, stop))
+                    return stop;
+            return scan_fields_scalar(p, first, last, set, bounds);
+        }
+
+        MPARSERS_TARGET("sse2")
+        inline uint64_t char_mask_sse2(const char* p, char ch)
+        {
+            const __m128i q = _mm_set1_epi8(ch);
+            uint64_t mask = 0;
+            for(int k = 0; k < 4; ++k)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16*k));
+                mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (16*k);
+            }
+            return mask;
+        }
+
+        template <class set_t>
+        MPARSERS_TARGET("sse2")
+        const char* scan_quoted_sse2(const char* p, const char* first, const char* last, const set_t& set
+                                     , char quote, std::vector<uint32_t>& bounds, bool& inside)
+        {
+            const char* stop = last;
+            uint64_t carry = inside ? ~(uint64_t)0 : 0;
+            for(; p + 64 <= last; p += 64)
+            {
+                const uint64_t quoted = prefix_xor(char_mask_sse2(p, quote)) ^ carry;
+                carry = (uint64_t)((int64_t)quoted >> 63);
+                if(consume_mask(match_mask_sse2(p, set) & ~quoted, p, first, set, bounds, stop))
+                    return stop;
+            }
+            inside = carry != 0;
+            return scan_quoted_scalar(p, first, last, set, quote, bounds, inside);
+        }
+
+        template <class set_t>
+        MPARSERS_TARGET("avx2")
+        inline uint64_t match_mask_avx2(const char* p, const set_t& set)
+        {
+            const __m256i d = _mm256_set1_epi8(set.delimiter);
+            const __m256i c = _mm256_set1_epi8(set.comment);
+            const __m256i n = _mm256_set1_epi8(set.newline);
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            const __m256i mlo = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lo, d), _mm256_cmpeq_epi8(lo, c))
+                                                , _mm256_cmpeq_epi8(lo, n));
+            const __m256i mhi = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(hi, d), _mm256_cmpeq_epi8(hi, c))
+                                                , _mm256_cmpeq_epi8(hi, n));
+            return (uint64_t)(uint32_t)_mm256_movemask_epi8(mlo)
+                 | ((uint64_t)(uint32_t)_mm256_movemask_epi8(mhi) << 32);
+        }
+
+        template <class set_t>
+        MPARSERS_TARGET("avx2")
+        const char* scan_fields_avx2(const char* first, const char* last
+                                     , const set_t& set, std::vector<uint32_t>& bounds)
+        {
+            const char* p = first;
+            const char* stop = last;
+            for(; p + 64 <= last; p += 64)
+                if(consume_mask(match_mask_avx2(p, set), p, first, set, bounds, stop))
+                    return stop;
+            return scan_fields_scalar(p, first, last, set, bounds);
+        }
+
+        MPARSERS_TARGET("avx2")
+        inline uint64_t char_mask_avx2(const char* p, char ch)
+        {
+            const __m256i q = _mm256_set1_epi8(ch);
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            return (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q))
+                 | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q)) << 32);
+        }
+
+        template <class set_t>
+        MPARSERS_TARGET("avx2")
+        const char* scan_quoted_avx2(const char* p, const char* first, const char* last, const set_t& set
+                                     , char quote, std::vector<uint32_t>& bounds, bool& inside)
+        {
+            const char* stop = last;
+            uint64_t carry = inside ? ~(uint64_t)0 : 0;
+            for(; p + 64 <= last; p += 64)
+            {
+                const uint64_t quoted = prefix_xor(char_mask_avx2(p, quote)) ^ carry;
+                carry = (uint64_t)((int64_t)quoted >> 63);
+                if(consume_mask(match_mask_avx2(p, set) & ~quoted, p, first, set, bounds, stop))
+                    return stop;
+            }
+            inside = carry != 0;
+            return scan_quoted_scalar(p, first, last, set, quote, bounds, inside);
+        }
+#endif
+    } /* namespace detail */
+
+    /** \brief scan a buffer for field delimiters, stopping at the first comment starter or end of line.
+     * The offset (from first) of every delimiter met before the stop is appended to bounds.
+     * \param [in] first: first character to scan
+     * \param [in] last: one past the last character to scan
+     * \param [in] set: characters to look for
+     * \param [in,out] bounds: receives delimiters offsets, it is not cleared
+     * \return pointer to the comment starter or end of line that stopped the scan, last if none
+     */
+    template <class set_t>
+    inline const char* scan_fields(const char* first, const char* last
+                                   , const set_t& set, std::vector<uint32_t>& bounds)
+    {
+#ifdef MPARSERS_HAVE_X86_SIMD
+        if(last - first >= 64)
+        {
+            switch(simd_level())
+            {
+                case SIMD_AVX2: return detail::scan_fields_avx2(first, last, set, bounds);
+                case SIMD_SSE2: return detail::scan_fields_sse2(first, last, set, bounds);
+                case SIMD_SCALAR: break;
+                default: break;
+            }
+        }
+#endif
+        return detail::scan_fields_scalar(first, first, last, set, bounds);
+    }
+
+    /** \brief go on with a scan_quoted_fields which reached the end of its buffer, once more bytes follow it.
+     * A row whose quoted field holds end of lines is then scanned once, line after line, instead of again from
+     * its beginning for each new line.
+     * \param [in] first: first character of the scanned buffer, the base of the offsets in bounds
+     * \param [in] from: where the previous scan stopped
+     * \param [in] last: one past the last character to scan
+     * \param [in] set: characters to look for
+     * \param [in] quote: quote character
+     * \param [in,out] bounds: delimiters offsets found so far, new ones are appended
+     * \param [in,out] open: is from between quotes? Receives true if last is reached between quotes
+     * \return pointer to the comment starter or end of line that stopped the scan, last if none
+     */
+    template <class set_t>
+    inline const char* resume_quoted_fields(const char* first, const char* from, const char* last, const set_t& set
+                                            , char quote, std::vector<uint32_t>& bounds, bool& open)
+    {
+#ifdef MPARSERS_HAVE_X86_SIMD
+        if(last - from >= 64)
+        {
+            switch(simd_level())
+            {
+                case SIMD_AVX2: return detail::scan_quoted_avx2(from, first, last, set, quote, bounds, open);
+                case SIMD_SSE2: return detail::scan_quoted_sse2(from, first, last, set, quote, bounds, open);
+                case SIMD_SCALAR: break;
+                default: break;
+            }
+        }
+#endif
+        return detail::scan_quoted_scalar(from, first, last, set, quote, bounds, open);
+    }
+
+    /** \brief same as scan_fields, for fields that can be quoted (RFC 4180).
+     * Delimiters, comment starters and end of lines between quotes are not matched. Quotes are found 64 bytes at a
+     * time, and the quoted bytes mask is the prefix xor of the quotes mask, so quotes do not branch. An escaped
+     * quote ("") closes and reopens the quoted part, which leaves it unchanged. Fields are returned with their
+     * quotes, see unquoted().
+     * \param [in] first: first character to scan, outside quotes
+     * \param [in] last: one past the last character to scan
+     * \param [in] set: characters to look for
+     * \param [in] quote: quote character
+     * \param [in,out] bounds: receives delimiters offsets, it is not cleared
+     * \param [out] open: true if last is reached between quotes
+     * \return pointer to the comment starter or end of line that stopped the scan, last if none
+     */
+    template <class set_t>
+    inline const char* scan_quoted_fields(const char* first, const char* last, const set_t& set, char quote
+                                          , std::vector<uint32_t>& bounds, bool& open)
+    {
+        open = false;
+        return resume_quoted_fields(first, first, last, set, quote, bounds, open);
+    }
+
+    /** \brief content of a field found by scan_quoted_fields, without its quotes.
+     * Escaped quotes ("") are only unescaped when the field holds some: otherwise the result points into field.
+     * \param [in] field: field, with its quotes
+     * \param [in] quote: quote character
+     * \param [out] scratch: holds the unescaped content, when needed
+     * \return field content, pointing into field or scratch
+     */
+    inline std::string_view unquoted(std::string_view field, char quote, std::string& scratch)
+    {
+        if(field.empty() || field.find(quote) == std::string_view::npos)
+            return field;
+        if(field.size() >= 2 && field.front() == quote && field.back() == quote
+           && field.find(quote, 1) == field.size() - 1)
+            return field.substr(1, field.size() - 2);
+        scratch.clear();
+        bool inside = false;
+        for(size_t it=0; it < field.size(); ++it)
+        {
+            if(field[it] != quote)
+                scratch.push_back(field[it]);
+            else if(inside && it + 1 < field.size() && field[it + 1] == quote)
+                scratch.push_back(field[++it]);
+            else
+                inside = !inside;
+        }
+        return scratch;
+    }
+
+    /** \brief call back fn(field_first, field_last) for each field found by scan_fields.
+     * A field is emitted for every delimiter, the last field only when it is not empty
+     * (the same rule as split).
+     * \param [in] first: first character of the scanned buffer
+     * \param [in] stop: value returned by scan_fields
+     * \param [in] bounds: offsets filled by scan_fields
+     * \param [in] fn: callable receiving (const char* first, const char* last)
+     */
+    template <class fn_t>
+    inline void for_each_field(const char* first, const char* stop, const std::vector<uint32_t>& bounds, fn_t&& fn)
+    {
+        const char* start = first;
+        for(uint32_t b : bounds)
+        {
+            fn(start, first + b);
+            start = first + b + 1;
+        }
+        if(start < stop)
+            fn(start, stop);
+    }
+
+    /** \brief number of fields for_each_field emits
+     * \param [in] first: first character of the scanned buffer
+     * \param [in] stop: value returned by scan_fields
+     * \param [in] bounds: offsets filled by scan_fields
+     */
+    inline size_t field_count(const char* first, const char* stop, const std::vector<uint32_t>& bounds)
+    {
+        const char* start = bounds.empty() ? first : first + bounds.back() + 1;
+        return bounds.size() + (start < stop ? 1 : 0);
+    }
+
+    /** \brief one field found by scan_fields, without visiting the previous ones
+     * \param [in] first: first character of the scanned buffer
+     * \param [in] stop: value returned by scan_fields
+     * \param [in] bounds: offsets filled by scan_fields
+     * \param [in] idx: field index, lower than field_count
+     */
+    inline std::string_view field_at(const char* first, const char* stop, const std::vector<uint32_t>& bounds
+                                     , size_t idx)
+    {
+        const char* start = idx ? first + bounds[idx - 1] + 1 : first;
+        const char* end = idx < bounds.size() ? first + bounds[idx] : stop;
+        return std::string_view(start, end - start);
+    }
+
+    /**
+    * \}
+    */
+} /* namespace mparsers */
+
+#endif /* M_CHAR_SCAN_HEADER */
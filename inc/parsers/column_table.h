@@ -0,0 +1,137 @@
+#ifndef M_COLUMN_TABLE_HEADER
+#define M_COLUMN_TABLE_HEADER
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <cstdint>
+#include <utility>
+#include <parsers/csv_schema.h>
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file column_table.h
+ * \brief column-major (struct of arrays) storage of a whole csv file
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief strings of one column, stored back to back in one character arena.
+ * The i-th value spans [offsets[i], offsets[i+1]) in arena.
+ */
+struct string_column_t
+{
+    std::string             arena;      //!< all values, back to back
+    std::vector<uint64_t>   offsets;    //!< values boundaries, size() + 1 entries
+
+    string_column_t(): arena(), offsets(1, 0) {}
+
+    //!< @brief number of values
+    inline size_t size() const {return offsets.size() - 1;}
+    //!< @brief is the column empty?
+    inline bool empty() const {return offsets.size() == 1;}
+    //!< @brief value of the idx-th row, valid as long as the column is not modified
+    inline std::string_view operator[](size_t idx) const
+    {return std::string_view(arena.data() + offsets[idx], offsets[idx+1] - offsets[idx]);}
+    //!< @brief append a value
+    inline void push_back(std::string_view value)
+    {
+        arena.append(value.data(), value.size());
+        offsets.push_back(arena.size());
+    }
+    //!< @brief preallocate room for rows values
+    inline void reserve(size_t rows) {offsets.reserve(rows + 1);}
+};
+
+/**
+ * \brief storage type of one schema column: a contiguous array for numbers, a string_column_t for strings
+ */
+template <class T>
+struct column_storage_t
+{
+    typedef std::vector<T> type;    //!< numbers are stored contiguously
+};
+
+template <>
+struct column_storage_t<std::string_view>
+{
+    typedef string_column_t type;   //!< views are copied into the column arena
+};
+
+template <>
+struct column_storage_t<std::string>
+{
+    typedef string_column_t type;   //!< strings are copied into the column arena
+};
+
+/**
+ * \brief column-major table loaded by csv_parser_t::load_columns.
+ * Without schema, it holds the first min_useful_columns columns of every valid row, as strings.
+ */
+template <class __schema>
+struct column_table_t
+{
+    std::vector<string_column_t>    columns;    //!< one entry per column
+    std::vector<int>                lines;      //!< line number of each row in input file
+
+    column_table_t(): columns(), lines() {}
+
+    //!< @brief number of rows
+    inline size_t rows() const {return lines.size();}
+    //!< @brief idx-th column
+    inline const string_column_t& column(size_t idx) const {return columns[idx];}
+};
+
+/**
+ * \brief column-major table of a typed schema, one storage per schema column
+ */
+template <class... __columns>
+struct column_table_t<schema_t<__columns...>>
+{
+    typedef std::tuple<typename column_storage_t<__columns>::type...> columns_t;   //!< columns storage
+
+    columns_t           columns;    //!< one storage per schema column
+    std::vector<int>    lines;      //!< line number of each row in input file
+
+    column_table_t(): columns(), lines() {}
+
+    //!< @brief number of rows
+    inline size_t rows() const {return lines.size();}
+    //!< @brief __index-th column
+    template <size_t __index>
+    inline const typename std::tuple_element<__index, columns_t>::type& column() const {return std::get<__index>(columns);}
+
+    /**
+    * \brief append a converted row
+    * \param [in] record: row columns
+    * \param [in] line: row line number
+    */
+    void push_back(const std::tuple<__columns...>& record, int line)
+    {
+        push_back(record, std::index_sequence_for<__columns...>());
+        lines.push_back(line);
+    }
+
+private:
+    template <size_t... __index>
+    void push_back(const std::tuple<__columns...>& record, std::index_sequence<__index...>)
+    {
+        (std::get<__index>(columns).push_back(std::get<__index>(record)), ...);
+    }
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_COLUMN_TABLE_HEADER
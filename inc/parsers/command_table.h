@@ -0,0 +1,122 @@
+#ifndef M_COMMAND_TABLE_HEADER
+#define M_COMMAND_TABLE_HEADER
+
+#include <string_view>
+#include <type_traits>
+#include <cstddef>
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file command_table.h
+ * \brief compile-time command registry for opt_parser_t
+ * \author Marouane BELAOUCHA
+ */
+
+/** \brief length of a constant C string
+ */
+constexpr size_t const_strlen(const char* s)
+{
+    size_t len = 0;
+    while(s[len])
+        ++len;
+    return len;
+}
+
+/**
+ * \brief one entry of a command_table_t: a command name and the function handling it.
+ * The handler is called directly (it can be inlined), with the same arguments as opt_parser_t callbacks,
+ * except the command which is given as a std::string_view:
+ * bool handler(std::string_view cmd, char* value, void* userdata, int line).
+ * Its result interrupts the parse when true.
+ * \tparam __name: command name, a constexpr char array with static storage
+ * \tparam __handler: handling function
+ */
+template <const char* __name, auto __handler>
+struct command_t
+{
+    static constexpr std::string_view name{__name, const_strlen(__name)};  //!< command name
+
+    //!< @brief call the handler if cmd is this command
+    static inline bool match(std::string_view cmd, char* value, void* userdata, int line, bool& interrupt)
+    {
+        if(cmd.size() != name.size() || cmd[0] != name[0] || cmd != name)
+            return false;
+        interrupt = __handler(cmd, value, userdata, line);
+        return true;
+    }
+};
+
+/**
+ * \brief list of commands known at compile time.
+ * Name matching is unrolled at compile time into length and first character tests followed by a fixed size
+ * comparison, and handlers are called without type erasure. A filler exposes it as a command_table typedef,
+ * then opt_parser_t#init uses it instead of (or on top of) register_commands:
+
+~~~~~~~~~~
+struct my_filler_t
+{
+    static constexpr char one[] = "COMMAND_ONE";
+    static constexpr char two[] = "COMMAND_two";
+    static bool on_one(std::string_view cmd, char* value, void* userdata, int line);
+    static bool on_two(std::string_view cmd, char* value, void* userdata, int line);
+
+    typedef command_table_t<command_t<one, &on_one>, command_t<two, &on_two>> command_table;
+};
+
+opt_parser_t parser;
+parser.init<my_filler_t>(&my_config);
+parser.parse("my_config_file.cfg");
+~~~~~~~~~~
+ * When a name appears twice, the first entry wins.
+ */
+template <class... __commands>
+struct command_table_t
+{
+    static constexpr size_t size = sizeof...(__commands);  //!< number of commands
+
+    /** \brief call the handler of a command
+     * \param [in] cmd: command name, not empty
+     * \param [in,out] value: command value
+     * \param [in,out] userdata: user data given to the handler
+     * \param [in] line: line number
+     * \param [out] interrupt: handler result, untouched if the command is unknown
+     * \return true if the command is in the table
+     */
+    static bool dispatch(std::string_view cmd, char* value, void* userdata, int line, bool& interrupt)
+    {
+        return (__commands::match(cmd, value, userdata, line, interrupt) || ...);
+    }
+};
+
+/**
+ * \brief does filler_t declare a command_table?
+ */
+template <class filler_t, class = void>
+struct has_command_table : std::false_type {};
+
+template <class filler_t>
+struct has_command_table<filler_t, std::void_t<typename filler_t::command_table>> : std::true_type {};
+
+/**
+ * \brief does filler_t provide register_commands?
+ */
+template <class filler_t, class = void>
+struct has_register_commands : std::false_type {};
+
+template <class filler_t>
+struct has_register_commands<filler_t, std::void_t<decltype(&filler_t::register_commands)>> : std::true_type {};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_COMMAND_TABLE_HEADER
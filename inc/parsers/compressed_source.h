@@ -0,0 +1,173 @@
+#ifndef M_COMPRESSED_SOURCE_HEADER
+#define M_COMPRESSED_SOURCE_HEADER
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cassert>
+#include <parsers/block_reader.h>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file compressed_source.h
+ * \brief input sources decompressing gzip and zstd files on the fly
+ * \author Marouane BELAOUCHA
+ *
+ * gzip needs zlib (build with MPARSERS_HAVE_ZLIB and link -lz), zstd needs libzstd (build with
+ * MPARSERS_HAVE_ZSTD and link -lzstd). Without them, files in these formats can not be opened.
+ */
+
+/**
+ * \brief compression formats, detected from the first bytes of a file
+ */
+enum compression_t
+{
+    COMPRESSION_NONE = 0,   //!< plain file
+    COMPRESSION_GZIP,       //!< gzip (1f 8b)
+    COMPRESSION_ZSTD        //!< zstandard (28 b5 2f fd)
+};
+
+/**
+ * \brief detect the compression format of a file from its magic bytes
+ * \param [in] filename: file to inspect
+ * \return detected format, COMPRESSION_NONE if the file is not compressed or can not be read
+ */
+compression_t detect_compression(const std::string& filename);
+
+/**
+ * \brief is a compression format supported by this build?
+ * \param [in] format: compression format
+ */
+bool compression_supported(compression_t format);
+
+/**
+ * \brief reads a compressed file, decompressed by a separate thread.
+ * The thread decompresses into one of two blocks while the reader consumes the other one, so decompression
+ * overlaps with parsing. Nothing is written to disk.
+ */
+struct decompress_source_t : public input_source_t
+{
+    static const size_t default_block_size = 1 << 20;      //!< 1 MiB
+
+    /**
+    * \param [in] block_size: size of each of the two decompressed blocks
+    */
+    explicit decompress_source_t(size_t block_size = default_block_size);
+    ~decompress_source_t() override;
+
+    /**
+    * \brief open a compressed file, and start decompressing it
+    * \param [in] filename: gzip or zstd file
+    * \return false if the file can not be read, or its format is not supported
+    */
+    bool open(const std::string& filename);
+    size_t read(char* buffer, size_t size) override;
+
+    //!< @brief was the stream corrupted or truncated? Reading then stops after the last readable bytes
+    bool failed() const;
+
+    struct decoder_t;   //!< format specific decompressor, defined with the supported formats
+
+private:
+    //!< @brief decompression thread body
+    void produce();
+    //!< @brief stop and join the decompression thread
+    void stop();
+
+    /** \brief one decompressed block
+     */
+    struct block_t
+    {
+        std::unique_ptr<char[]> data;   //!< decompressed bytes
+        size_t                  size;   //!< decompressed bytes in data
+
+        block_t(): data(), size(0) {}
+    };
+
+    decoder_t*                  decoder;        //!< format specific decompressor, owned
+    block_t                     blocks[2];      //!< double buffer
+    size_t                      block_size;     //!< capacity of each block
+    int                         ready;          //!< decompressed blocks waiting to be read (0 to 2)
+    int                         producing;      //!< block the thread fills next
+    int                         consuming;      //!< block read() takes bytes from
+    size_t                      position;       //!< first unread byte of the consumed block
+    bool                        finished;       //!< the thread decompressed its last block
+    bool                        stopping;       //!< the thread has to stop
+    bool                        error;          //!< the stream is corrupted or truncated
+    mutable std::mutex          lock;           //!< guards the blocks state
+    std::condition_variable     changed;        //!< signals blocks state changes
+    std::thread                 worker;         //!< decompression thread
+
+    decompress_source_t(const decompress_source_t&):
+          input_source_t()
+        , decoder(nullptr)
+        , blocks()
+        , block_size(0)
+        , ready(0)
+        , producing(0)
+        , consuming(0)
+        , position(0)
+        , finished(true)
+        , stopping(true)
+        , error(false)
+        , lock()
+        , changed()
+        , worker()
+    {GO_UNREACHABLE();}
+    const decompress_source_t& operator=(const decompress_source_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+ * \brief reads a file, decompressing it on the fly when its magic bytes tell it is compressed
+ */
+struct auto_file_source_t : public input_source_t
+{
+    auto_file_source_t(): plain(), archive(), format(COMPRESSION_NONE) {}
+
+    /**
+    * \brief open a plain or compressed file
+    * \param [in] filename: file to read
+    * \return true on success
+    */
+    bool open(const std::string& filename);
+
+    /**
+    * \brief move the read position of a plain file
+    * \param [in] offset: byte offset from the beginning of the file
+    * \return true on success, always false for compressed files
+    */
+    inline bool seek(uint64_t offset) {return format == COMPRESSION_NONE && plain.seek(offset);}
+    size_t read(char* buffer, size_t size) override;
+
+    //!< @brief format of the opened file
+    inline compression_t compression() const {return format;}
+    //!< @brief was the compressed file corrupted or truncated? Always false for plain files
+    bool failed() const;
+
+private:
+    file_source_t           plain;      //!< plain file
+    decompress_source_t     archive;    //!< compressed file
+    compression_t           format;     //!< format of the opened file
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_COMPRESSED_SOURCE_HEADER
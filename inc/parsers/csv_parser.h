@@ -1,210 +1,1931 @@
-#ifndef CSV_UTILS_HEADER
-#define CSV_UTILS_HEADER
-
-#include <vector>
-#include <algorithm>
-#include <functional>
-#include <fstream>
-#include <misc/mstring_utils.h>
-
-
-
-namespace mparsers
-{
-
-/**
- * \addtogroup parsers_group Parsers
- * @{
- */
-
- /**
- * \file csv_parser.h
- * \brief parser for .CVS (column separated files)
- * \author Marouane BELAOUCHA
- */
-
- /**
- * \brief This class wraps csv (column separated values) files, and grant access to its lines.
- * This class implements a traversal for csv files. user has to provide a callback function which
- * will be called each time the traversal matches a valid CSV line. This class makes CSV files management
- * as easy as the following example (with an anonymous function):
-
-~~~~~~~~~~{.c}
-#include <iostream>
-#include <libmparsers.h>
-using namespace std;
-using namespace mparsers;
-
-int main(int , char**)
-{
-    csv_parser_t<';','#'> my_csv_parser(3); // needs 3 columns and more
-    my_csv_parser.each_row("my_input_file.csv",
-                           [](const csv_parser_t<';','#'>::row_t& current_row, int current_line) -> void
-    {
-        cout<<"\line#"<<current_line<<": ";
-        for(size_t it=0; it< current_row.size(); ++it)
-            cout<<current_row[it]<<";";
-    });
-}
-~~~~~~~~~~
-Or, the same example with a C-like function as callback:
-
-~~~~~~~~~~{.c}
-#include <iostream>
-#include <libmparsers.h>
-using namespace std;
-using namespace mparsers;
-
-void call_this_back(const csv_parser_t<';','#'>::row_t& current_row, int current_line)
-{
-    cout<<"\line#"<<current_line<<": ";
-    for(size_t it=0; it< current_row.size(); ++it)
-        cout<<current_row[it]<<";";
-}
-
-int main(int , char**)
-{
-    csv_parser_t<';','#'> my_csv_parser(3); // needs 3 columns and more
-    my_csv_parser.each_row('my_input_file.csv', call_this_back);
-}
-~~~~~~~~~~
-
-
-
- */
-template <char __delimiter,char __comment_starter>
-struct csv_parser_t
-{
-    /** \brief represents a row of a csv file
-     */
-
-    struct row_t
-    {
-        public:
-            std::vector<std::string> fields;    //!< list of columns content
-        public:
-            row_t():fields(){}
-            //!< @brief is the row empty?
-            inline bool empty() const {return fields.empty();}
-            //!< @brief return the number of columns
-            inline int  size()  const {return fields.size();}
-            //!< @brief clear columns
-            inline void clear() {fields.clear();}
-            //!< @brief grant read only random access to columns
-            std::string& operator[](int idx) { return fields[idx];}
-            //!< @brief grant read write random access to columns
-            const std::string& operator[](int idx) const{ return fields[idx];}
-            //!< @brief assign row_t object to another
-            const row_t& operator=(const row_t& o) {fields = o.fields;return *this;}
-            /**
-            * @brief this assumes that the string object holds a csv line. It will be split into columns
-            * @param [in] s: csv line
-            * return reference the this
-            */
-            const row_t& operator=(const std::string& s)
-            {*this=split(ignore_comment(s,__comment_starter),__delimiter);;return *this;}
-            /**
-            * @brief this assumes that the string object holds a csv line. It will be split into columns
-            * @param [in] s: csv line
-            * return reference the this
-            */
-            const row_t& operator=(const char* s)
-            {*this=split(ignore_comment(s,__comment_starter),__delimiter);return *this;}
-
-        private:
-            const row_t& operator=(const std::vector<std::string>& o) {fields = o; return *this;}
-    };
-
-    int min_useful_columns;              //!< minimum columns to consider. Any line having less than this threshold are ignored.
-    int lineno;                          //!< current line number
-
-
-    /** \brief default construct
-     * \param [in] mc: minimal useful columns
-     */
-    csv_parser_t(int mc =0):
-          min_useful_columns(mc)
-        , lineno (0)
-        {
-        }
-
-    /** \brief iterates over file lines, and call user function back
-     * the user callback function receives two parameters:
-     *     - the current row
-     *     - the current line number in input file
-     * Then, it has to do its own process
-     * \param [in] fn: filename
-     * \param [in] callback: user callback
-     * \return number of valid csv lines
-     * \example each_row(std::cin, [](const row_t&, int lineno){do something})
-     */
-    int each_row(const std::string&fn,const std::function<void(const row_t&,int)>& callback)
-    {
-        std::ifstream ifs(fn);
-        lineno = 0;
-        int parsed = each_row(ifs,callback);
-        ifs.close();
-        return parsed;
-    }
-private:
-    /** \brief iterates over stream lines, and call user function back
-     * the user callback function receives two parameters:
-     *     - the current row
-     *     - the current line number in input file
-     * Then, it has to do its own process
-     * \param [in] in: input stream
-     * \param [in] callback: user callback
-     * \return number of valid csv lines
-     * \example each_row(std::cin, [](const row_t&, int lineno){do something})
-     */
-    int each_row(std::istream& in,const std::function<void(const row_t&,int)>& callback)
-    {
-        int parsed=0;
-        while(in.good())
-            parsed+=next(in,callback);
-        return parsed;
-    }
-
-    /** \brief parses next line, and call user function back if valid
-     * the user callback function receives two parameters:
-     *     - the current row
-     *     - the current line number in input file
-     * Then, it has to do its own process
-     * \param [in] in: input stream
-     * \param [in] callback: user callback
-     * \return number 1 if the csv line is valid, 0 otherwise
-     * \example each_row("some_file.csv", [](const row_t&, int lineno){do something})
-     */
-
-    int next(std::istream&in, const std::function<void(const row_t&,int)>& callback)
-    {
-        if(in.good())
-        {
-            char line[3*1024];
-            in.getline(line,sizeof(line));
-            lineno++;
-            row_t current ;
-            current =line;
-            //current = line;
-            if(current.size() < min_useful_columns)
-                return 0;
-            if(callback)
-                callback(current,lineno);
-            return 1;
-        }
-        return 0;
-    }
-
-};
-
-typedef csv_parser_t<';','#'> tranche_file_parser_t;    //!< tranche file parser
-typedef csv_parser_t<';','#'> format_file_parser_t;     //!< format file parser
-typedef csv_parser_t<';','#'> labels_file_parser_t;     //!< labels file parser
-typedef csv_parser_t<';','#'> generic_csv_parser_t;     //!< labels file parser
-/**
-* @} // addtogroup
-*/
-
-} /*namespace mparsers*/
-
-#endif // CSV_UTILS_HEADER
+#ifndef CSV_UTILS_HEADER
+#define CSV_UTILS_HEADER
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <deque>
+#include <numeric>
+#include <array>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <string_view>
+#include <parsers/mstring_utils.h>
+#include <parsers/mapped_file.h>
+#include <parsers/block_reader.h>
+#include <parsers/compressed_source.h>
+#include <parsers/line_index.h>
+#include <parsers/parse_stats.h>
+#include <parsers/string_pool.h>
+#include <parsers/char_scan.h>
+#include <parsers/thread_pool.h>
+#include <parsers/csv_schema.h>
+#include <parsers/column_table.h>
+
+
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+ /**
+ * \file csv_parser.h
+ * \brief parser for .CVS (column separated files)
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief rows handed at once to a batch callback (see csv_parser_t::each_view_row_batch).
+ * Fields of all rows are stored one after the other, and point into the parsed file: they stay valid until
+ * the parse returns.
+ */
+struct row_batch_t
+{
+    std::vector<std::string_view>   fields;     //!< fields of all rows, row after row
+    std::vector<uint32_t>           ends;       //!< one past the last field of each row, in fields
+    std::vector<int>                lines;      //!< line number of each row
+
+    row_batch_t(): fields(), ends(), lines() {}
+
+    //!< @brief number of rows
+    inline size_t size() const {return lines.size();}
+    //!< @brief is the batch empty?
+    inline bool empty() const {return lines.empty();}
+    //!< @brief line number of a row
+    inline int line(size_t r) const {return lines[r];}
+    //!< @brief number of fields of a row
+    inline size_t columns(size_t r) const {return ends[r] - begin(r);}
+    //!< @brief first field of a row, followed by its other columns(r) - 1 fields
+    inline const std::string_view* row(size_t r) const {return fields.data() + begin(r);}
+    //!< @brief one field of a row
+    inline std::string_view field(size_t r, size_t column) const {return fields[begin(r) + column];}
+
+    /**
+    * @brief append a row
+    * @param [in] row_fields: fields of the row
+    * @param [in] line: line number of the row
+    */
+    inline void push_back(const std::vector<std::string_view>& row_fields, int line)
+    {
+        fields.insert(fields.end(), row_fields.begin(), row_fields.end());
+        ends.push_back(fields.size());
+        lines.push_back(line);
+    }
+    //!< @brief remove every row, keeping the storage
+    inline void clear() {fields.clear(); ends.clear(); lines.clear();}
+
+private:
+    inline size_t begin(size_t r) const {return r ? ends[r - 1] : 0;}
+};
+
+namespace detail
+{
+    /** \brief can a callback be null? Such callbacks are tested before being called */
+    template <class fn_t>
+    struct is_nullable_callback : std::is_pointer<fn_t> {};
+
+    template <class signature_t>
+    struct is_nullable_callback<std::function<signature_t>> : std::true_type {};
+
+    /** \brief call a callable, telling whether it asks to stop: callables returning bool stop with true
+     */
+    template <class fn_t, class... args_t>
+    inline bool invoke_callback(fn_t& callback, const args_t&... args)
+    {
+        if constexpr (std::is_same_v<std::invoke_result_t<fn_t&, const args_t&...>, bool>)
+            return callback(args...);
+        else
+        {
+            callback(args...);
+            return false;
+        }
+    }
+
+    /** \brief call a user callback: any callable, a null std::function or pointer, or nullptr
+     * \return true if the callback asks to stop the parse
+     */
+    template <class fn_t, class... args_t>
+    inline bool call_back(fn_t& callback, const args_t&... args)
+    {
+        typedef std::remove_cv_t<fn_t> callback_t;
+        if constexpr (std::is_same_v<callback_t, std::nullptr_t>)
+            return false;
+        else if constexpr (is_nullable_callback<callback_t>::value)
+            return callback ? invoke_callback(callback, args...) : false;
+        else
+            return invoke_callback(callback, args...);
+    }
+
+    /** \brief decides which lines a parse splits, and when it has delivered enough rows (see csv_parser_t::limits_t)
+     */
+    struct line_sampler_t
+    {
+        line_sampler_t(int skip_lines, int max_rows, int stride, double rate, uint64_t seed):
+              __skip_lines(skip_lines)
+            , __max_rows(max_rows)
+            , __stride(std::max(stride, 1))
+            , __random_sampling(rate < 1.0)
+            , __threshold(rate < 1.0 ? (uint64_t)(std::max(rate, 0.0) * 18446744073709551616.0) : 0)
+            , __random(seed)
+            , __rows(0)
+            , __all(skip_lines <= 0 && stride <= 1 && rate >= 1.0)
+        {}
+
+        //!< @brief is a line left out? Lines have to be asked for in increasing order
+        inline bool skip(int line)
+        {
+            if(__all)
+                return false;
+            if(line <= __skip_lines)
+                return true;
+            if(__stride > 1 && (line - __skip_lines - 1) % __stride)
+                return true;
+            return __random_sampling && next() >= __threshold;
+        }
+        //!< @brief count a delivered row
+        inline void delivered() {++__rows;}
+        //!< @brief were max_rows rows delivered?
+        inline bool full() const {return __max_rows > 0 && __rows >= __max_rows;}
+
+    private:
+        int         __skip_lines;       //!< lines skipped at the beginning
+        int         __max_rows;         //!< rows to deliver, 0 for no limit
+        int         __stride;           //!< one line kept out of __stride
+        bool        __random_sampling;  //!< are lines kept at random?
+        uint64_t    __threshold;        //!< random values below it keep their line
+        uint64_t    __random;           //!< random generator state
+        int         __rows;             //!< rows delivered so far
+        bool        __all;              //!< is every line kept?
+
+        /* splitmix64: one add and a few multiplies per sampled line */
+        inline uint64_t next()
+        {
+            uint64_t z = (__random += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+    };
+} /* namespace detail */
+
+ /**
+ * \brief This class wraps csv (column separated values) files, and grant access to its lines.
+ * This class implements a traversal for csv files. user has to provide a callback function which
+ * will be called each time the traversal matches a valid CSV line. This class makes CSV files management
+ * as easy as the following example (with an anonymous function):
+
+~~~~~~~~~~{.c}
+#include <iostream>
+#include <libmparsers.h>
+using namespace std;
+using namespace mparsers;
+
+int main(int , char**)
+{
+    csv_parser_t<';','#'> my_csv_parser(3); // needs 3 columns and more
+    my_csv_parser.each_row("my_input_file.csv",
+                           [](const csv_parser_t<';','#'>::row_t& current_row, int current_line) -> void
+    {
+        cout<<"\line#"<<current_line<<": ";
+        for(size_t it=0; it< current_row.size(); ++it)
+            cout<<current_row[it]<<";";
+    });
+}
+~~~~~~~~~~
+Or, the same example with a C-like function as callback:
+
+~~~~~~~~~~{.c}
+#include <iostream>
+#include <libmparsers.h>
+using namespace std;
+using namespace mparsers;
+
+void call_this_back(const csv_parser_t<';','#'>::row_t& current_row, int current_line)
+{
+    cout<<"\line#"<<current_line<<": ";
+    for(size_t it=0; it< current_row.size(); ++it)
+        cout<<current_row[it]<<";";
+}
+
+int main(int , char**)
+{
+    csv_parser_t<';','#'> my_csv_parser(3); // needs 3 columns and more
+    my_csv_parser.each_row('my_input_file.csv', call_this_back);
+}
+~~~~~~~~~~
+
+Large files can be traversed without copying anything with each_view_row: the file is memory mapped
+and each field is a std::string_view into the mapping, only valid during the callback:
+
+~~~~~~~~~~{.c}
+    csv_parser_t<';','#'> my_csv_parser(3);
+    my_csv_parser.each_view_row("my_input_file.csv",
+                           [](const csv_parser_t<';','#'>::view_row_t& current_row, int current_line) -> void
+    {
+        cout<<"\line#"<<current_line<<": "<<current_row[0];
+    });
+~~~~~~~~~~
+
+Giving a schema_t as third parameter converts columns with std::from_chars, right from the mapped file.
+The minimal number of useful columns is then at least the number of schema columns:
+
+~~~~~~~~~~{.c}
+    typedef csv_parser_t<';','#',schema_t<int64_t,double,std::string_view>> typed_parser_t;
+    typed_parser_t().each_record("my_input_file.csv",
+                           [](const typed_parser_t::record_t& record, int current_line) -> void
+    {
+        cout<<"\line#"<<current_line<<": "<<std::get<0>(record) + std::get<1>(record);
+    },
+                           [](const parse_error_t& error) -> void
+    {
+        cerr<<"line#"<<error.line<<": bad column "<<error.column;
+    });
+~~~~~~~~~~
+
+Giving a quote character as fourth parameter enables quoted fields (RFC 4180): delimiters, comment starters
+and end of lines between quotes are part of the field, and "" stands for one quote inside a quoted field.
+row_t fields are unquoted; view_row_t fields keep their quotes until view_row_t::unquoted reads them:
+
+~~~~~~~~~~{.c}
+    csv_parser_t<';','#',untyped_t,'"'> quoted_parser(2);
+    std::string scratch;
+    quoted_parser.each_view_row("my_input_file.csv",
+                           [&scratch](const csv_parser_t<';','#',untyped_t,'"'>::view_row_t& current_row, int) -> void
+    {
+        cout<<current_row.unquoted(1, scratch);
+    });
+~~~~~~~~~~
+Line numbers are the ones of the first line of each row. The incremental parse, each_view_row_parallel and line
+indexes cut the input at end of lines: they need quoted fields without end of lines.
+
+Giving collect_stats_t as fifth parameter makes the parser count lines, rows, rejected, comment and empty lines,
+bytes read, and time reading, scanning, materializing fields and calling back. The default no_stats_t compiles
+every counter out:
+
+~~~~~~~~~~{.c}
+    csv_parser_t<';','#',untyped_t,0,collect_stats_t> counted_parser;
+    counted_parser.each_row("my_input_file.csv", nullptr);
+    cerr<<counted_parser.stats().to_json();
+~~~~~~~~~~
+
+A callback returning bool stops the parse when it returns true. set_limits skips leading lines and caps the
+delivered rows, and set_sampling splits only some of the lines, the other ones are skipped without being split:
+
+~~~~~~~~~~{.c}
+    csv_parser_t<';','#'> preview_parser(3);
+    preview_parser.set_limits(1, 20);         // skip the header, then 20 rows at most
+    preview_parser.set_sampling(1, 0.001);    // out of about 0.1% of the lines
+    preview_parser.each_row("my_input_file.csv", [](const csv_parser_t<';','#'>::row_t& current_row, int)
+    {
+        return current_row[0] == "last";      // true stops the parse
+    });
+~~~~~~~~~~
+
+rows() gives the rows of each_row as a lazy input range instead: the file is read as the loop pulls rows, and
+leaving the loop stops the parse. With C++20, it composes with std::views:
+
+~~~~~~~~~~{.c}
+    csv_parser_t<';','#'> my_csv_parser(3);
+    auto rows = my_csv_parser.rows("my_input_file.csv");
+    for(const auto& current_row : rows | std::views::filter(is_wanted) | std::views::take(10))
+        cout<<current_row[0];
+~~~~~~~~~~
+
+ */
+template <char __delimiter,char __comment_starter, class __schema = untyped_t, char __quote = 0
+          , class __stats_t = no_stats_t>
+struct csv_parser_t
+{
+    typedef static_scan_set_t<__delimiter,__comment_starter> scan_set;  //!< compile-time characters to scan for
+    typedef typename __schema::record_t record_t;                       //!< converted row, when a schema_t is given
+
+    /** \brief columns each_row has to materialize, and rows it has to drop before building them
+     */
+    struct projection_t
+    {
+        std::vector<int>                        columns;    //!< needed columns, in row fields order. Empty means every column
+        int                                     key_column; //!< column given to the predicate
+        std::function<bool(std::string_view)>   predicate;  //!< rows whose key column is rejected are dropped, may be null
+
+        projection_t(): columns(), key_column(0), predicate() {}
+
+        //!< @brief are all the columns of every row needed?
+        inline bool empty() const {return columns.empty() && !predicate;}
+
+        //!< @brief fields a line needs to hold the projected columns and the key column
+        inline int min_columns() const
+        {
+            int needed = predicate ? key_column + 1 : 0;
+            for(int c : columns)
+                needed = std::max(needed, c + 1);
+            return needed;
+        }
+    };
+
+    /** \brief lines each_row, rows and each_view_row read, and rows they deliver
+     */
+    struct limits_t
+    {
+        int         skip_lines; //!< lines skipped at the beginning of the input, without being split
+        int         max_rows;   //!< the parse stops once this many rows are delivered, 0 for no limit
+        int         stride;     //!< only one line out of stride is split (the first one after skip_lines), 1 keeps all
+        double      rate;       //!< probability for a line to be split, 1 keeps all
+        uint64_t    seed;       //!< seed of the random line sampling, the same seed samples the same lines
+
+        limits_t(): skip_lines(0), max_rows(0), stride(1), rate(1.0), seed(0) {}
+
+        //!< @brief is every line of the input split and delivered?
+        inline bool empty() const {return skip_lines <= 0 && max_rows <= 0 && stride <= 1 && rate >= 1.0;}
+    };
+
+    /** \brief represents a row of a csv file
+     */
+
+    struct row_t
+    {
+        public:
+            std::vector<std::string> fields;    //!< list of columns content
+        public:
+            row_t():fields(), __bounds(), __spare(), __scratch(), __open(false), __interned(){}
+            //!< @brief is the row empty?
+            inline bool empty() const {return fields.empty();}
+            //!< @brief return the number of columns
+            inline int  size()  const {return fields.size();}
+            //!< @brief clear columns, keeping their storage for the next assign()
+            inline void clear() {resize(0);}
+            //!< @brief did the last assigned line end between quotes? The row then continues on the next line
+            inline bool open_quote() const {return __open;}
+            //!< @brief grant read only random access to columns
+            std::string& operator[](int idx) { return fields[idx];}
+            //!< @brief grant read write random access to columns
+            const std::string& operator[](int idx) const{ return fields[idx];}
+            /**
+            * @brief id of a column interned by the parser (see csv_parser_t::set_interned_columns) in its dictionary
+            * @param [in] idx: column index
+            * return string_pool_t::npos if the column is not interned
+            */
+            inline uint32_t id(int idx) const
+            {return (size_t)idx < __interned.size() ? __interned[idx].first : string_pool_t::npos;}
+            /**
+            * @brief content of a column: the dictionary string of an interned column, the field itself otherwise
+            * @param [in] idx: column index
+            */
+            inline std::string_view interned(int idx) const
+            {return id(idx) != string_pool_t::npos ? __interned[idx].second : std::string_view(fields[idx]);}
+            //!< @brief assign row_t object to another
+            const row_t& operator=(const row_t& o) {fields = o.fields; __interned = o.__interned; return *this;}
+            /**
+            * @brief this assumes that the string object holds a csv line. It will be split into columns
+            * @param [in] s: csv line
+            * return reference the this
+            */
+            const row_t& operator=(const std::string& s)
+            {return assign(s.data(), s.data() + s.size());}
+            /**
+            * @brief this assumes that the string object holds a csv line. It will be split into columns
+            * @param [in] s: csv line
+            * return reference the this
+            */
+            const row_t& operator=(const char* s)
+            {return assign(s, s + strlen(s));}
+            /**
+            * @brief split a csv line into columns, ignoring anything after a comment starter or an end of line.
+            * Columns are overwritten in place: once the row has seen its widest line, assigning does not allocate.
+            * @param [in] first: first character of the line
+            * @param [in] last: one past the last character of the line
+            * return reference the this
+            */
+            const row_t& assign(const char* first, const char* last)
+            {
+                return fill(first, scan(first, last));
+            }
+            /**
+            * @brief split a csv line, keeping only the projected columns of the lines passing the predicate.
+            * Fields are still located, but only the projected ones are copied, and nothing is copied from a
+            * rejected line.
+            * @param [in] first: first character of the line
+            * @param [in] last: one past the last character of the line
+            * @param [in] projection: columns to keep, and row predicate
+            * @param [in] min_columns: lines with less fields (or not holding every projected column) are rejected
+            * return false if the line is rejected, the row is then left empty
+            */
+            bool assign(const char* first, const char* last, const projection_t& projection, int min_columns)
+            {
+                return fill(first, scan(first, last), projection, min_columns);
+            }
+
+        private:
+            friend struct csv_parser_t;
+
+            std::vector<uint32_t>       __bounds;   //!< delimiters offsets, kept to reuse its storage
+            std::vector<std::string>    __spare;    //!< columns removed by the last assignments, kept with their storage
+            std::string                 __scratch;  //!< unescaped quoted field
+            bool                        __open;     //!< the last line ended between quotes
+            std::vector<std::pair<uint32_t, std::string_view>> __interned;   //!< id and dictionary string of each column
+
+            /* copy the fields located by scan(), interning the columns of dictionaries if any */
+            const row_t& fill(const char* first, const char* stop, column_dictionaries_t* dictionaries = nullptr)
+            {
+                if(!dictionaries)
+                    __interned.clear();
+                size_t count = 0;
+                for_each_field(first, stop, __bounds, [this, &count, dictionaries](const char* b, const char* e)
+                {
+                    if(count == fields.size())
+                        resize(count + 1);
+                    if(dictionaries)
+                        put(count, count, std::string_view(b, e - b), *dictionaries);
+                    else
+                        store(fields[count], std::string_view(b, e - b));
+                    count++;
+                });
+                resize(count);
+                return *this;
+            }
+
+            /* copy the projected fields located by scan(), false if the line is rejected */
+            bool fill(const char* first, const char* stop, const projection_t& projection, int min_columns
+                      , column_dictionaries_t* dictionaries = nullptr)
+            {
+                if(!dictionaries)
+                    __interned.clear();
+                const size_t count = field_count(first, stop, __bounds);
+                if(__open || (int)count < std::max(min_columns, projection.min_columns())
+                   || (projection.predicate
+                       && !projection.predicate(text(field_at(first, stop, __bounds, projection.key_column)))))
+                {
+                    resize(0);
+                    return false;
+                }
+                if(projection.columns.empty())
+                {
+                    resize(count);
+                    for(size_t c=0; c < count; ++c)
+                    {
+                        if(dictionaries)
+                            put(c, c, field_at(first, stop, __bounds, c), *dictionaries);
+                        else
+                            store(fields[c], field_at(first, stop, __bounds, c));
+                    }
+                    return true;
+                }
+                resize(projection.columns.size());
+                for(size_t c=0; c < projection.columns.size(); ++c)
+                {
+                    const size_t column = projection.columns[c];
+                    if(dictionaries)
+                        put(c, column, field_at(first, stop, __bounds, column), *dictionaries);
+                    else
+                        store(fields[c], field_at(first, stop, __bounds, column));
+                }
+                return true;
+            }
+
+            /* set field idx from file column, interning it when its column has a dictionary */
+            void put(size_t idx, size_t column, std::string_view field, column_dictionaries_t& dictionaries)
+            {
+                if(idx >= __interned.size())
+                    __interned.resize(idx + 1, std::make_pair(string_pool_t::npos, std::string_view()));
+                if(!dictionaries.has(column))
+                {
+                    store(fields[idx], field);
+                    __interned[idx].first = string_pool_t::npos;
+                    return;
+                }
+                string_pool_t& pool = dictionaries.pool(column);
+                const uint32_t id = pool.intern(text(field));
+                fields[idx].clear();
+                __interned[idx] = std::make_pair(id, pool.value(id));
+            }
+
+            /* locate the fields of a line, between quotes or not */
+            const char* scan(const char* first, const char* last)
+            {
+                __bounds.clear();
+                if constexpr (__quote != 0)
+                    return scan_quoted_fields(first, last, scan_set(), __quote, __bounds, __open);
+                else
+                    return scan_fields(first, last, scan_set(), __bounds);
+            }
+
+            /* scan the bytes appended after a line which ended between quotes, keeping the fields found so far */
+            const char* resume_scan(const char* first, const char* from, const char* last)
+            {
+                if constexpr (__quote != 0)
+                    return resume_quoted_fields(first, from, last, scan_set(), __quote, __bounds, __open);
+                else
+                    return scan(first, last);
+            }
+
+            /* field content, without its quotes */
+            std::string_view text(std::string_view field)
+            {
+                if constexpr (__quote != 0)
+                    return unquoted(field, __quote, __scratch);
+                else
+                    return field;
+            }
+
+            /* copy a field content, without its quotes */
+            void store(std::string& out, std::string_view field)
+            {
+                field = text(field);
+                out.assign(field.data(), field.size());
+            }
+
+            /* grow or shrink fields, moving strings (and their buffers) from or to __spare */
+            void resize(size_t count)
+            {
+                while(fields.size() > count)
+                {
+                    __spare.push_back(std::move(fields.back()));
+                    fields.pop_back();
+                }
+                while(fields.size() < count)
+                {
+                    if(__spare.empty())
+                        fields.emplace_back();
+                    else
+                    {
+                        fields.push_back(std::move(__spare.back()));
+                        __spare.pop_back();
+                    }
+                }
+                if(__interned.size() > count)
+                    __interned.resize(count);
+            }
+            const row_t& operator=(const std::vector<std::string>& o) {fields = o; __interned.clear(); return *this;}
+    };
+
+    /** \brief represents a row of a csv file without owning its content.
+     * Fields point straight into the mapped input file, so they are only valid during the callback.
+     * Copy them into std::string (or use row_t) to keep them longer.
+     */
+    struct view_row_t
+    {
+        public:
+            std::vector<std::string_view> fields;   //!< list of columns content
+        public:
+            view_row_t():fields(), __bounds(){}
+            //!< @brief is the row empty?
+            inline bool empty() const {return fields.empty();}
+            //!< @brief return the number of columns
+            inline int  size()  const {return fields.size();}
+            //!< @brief clear columns
+            inline void clear() {fields.clear();}
+            //!< @brief grant read only random access to columns
+            std::string_view operator[](int idx) const { return fields[idx];}
+            /**
+            * @brief column content, without its quotes when the parser has a quote character
+            * @param [in] idx: column index
+            * @param [out] scratch: holds the content when escaped quotes have to be unescaped
+            * return column content, pointing into the input or scratch
+            */
+            std::string_view unquoted(int idx, std::string& scratch) const
+            {
+                if constexpr (__quote != 0)
+                    return mparsers::unquoted(fields[idx], __quote, scratch);
+                else
+                    return fields[idx];
+            }
+            /**
+            * @brief split a csv line (without its end of line) into columns, the same way row_t does
+            * @param [in] first: first character of the line
+            * @param [in] last: one past the last character of the line
+            * return reference the this
+            */
+            const view_row_t& assign(const char* first, const char* last)
+            {
+                scan(first, last);
+                return *this;
+            }
+            /**
+            * @brief split a buffer into columns, until the first comment starter or end of line (out of quotes)
+            * @param [in] first: first character of the line
+            * @param [in] last: one past the last character of the buffer
+            * return the comment starter or end of line that stopped the scan, last if none
+            */
+            const char* scan(const char* first, const char* last)
+            {
+                fields.clear();
+                __bounds.clear();
+                const char* stop;
+                if constexpr (__quote != 0)
+                {
+                    bool open;
+                    stop = scan_quoted_fields(first, last, scan_set(), __quote, __bounds, open);
+                }
+                else
+                    stop = scan_fields(first, last, scan_set(), __bounds);
+                for_each_field(first, stop, __bounds, [this](const char* b, const char* e)
+                {
+                    fields.emplace_back(b, e - b);
+                });
+                return stop;
+            }
+
+        private:
+            std::vector<uint32_t> __bounds;     //!< delimiters offsets, kept to reuse its storage
+    };
+
+    /** \brief rows of a file or stream, read when pulled (see csv_parser_t::rows).
+     * This is a single pass input range: the input is read by blocks as the iterator moves forward, and
+     * nothing is read nor split beyond the row the consumer is looking at, so breaking out of a loop stops
+     * the parse. Rows are built into the row the parser reuses for each_row: the one an iterator refers to
+     * is overwritten when any iterator of the range moves. The parser must outlive the range, and must not
+     * parse anything else while the range is in use.
+     */
+    struct row_range_t
+    {
+        struct iterator
+        {
+            typedef std::input_iterator_tag    iterator_category;
+            typedef row_t                      value_type;
+            typedef std::ptrdiff_t             difference_type;
+            typedef const row_t*               pointer;
+            typedef const row_t&               reference;
+
+            //!< @brief end iterator
+            iterator(): __range(nullptr), __kept() {}
+            iterator(const iterator& o): __range(o.__range), __kept(o.__kept) {}
+            iterator& operator=(const iterator& o) {__range = o.__range; __kept = o.__kept; return *this;}
+
+            inline reference operator*() const {return __kept ? *__kept : __range->__parser->__current;}
+            inline pointer operator->() const {return &**this;}
+            //!< @brief line number of the current row, the first one of a row spanning several lines
+            inline int line() const {return __range->__line;}
+
+            //!< @brief read the next row, becoming the end iterator at the end of input
+            iterator& operator++()
+            {
+                if(__kept)
+                    __kept.reset();
+                if(!__range->next())
+                    __range = nullptr;
+                return *this;
+            }
+            //!< @brief read the next row, the returned iterator keeps a copy of the row the range overwrites
+            iterator operator++(int)
+            {
+                iterator previous(*this);
+                std::shared_ptr<row_t> kept = std::make_shared<row_t>();
+                *kept = **this;
+                previous.__kept = kept;
+                ++*this;
+                return previous;
+            }
+
+            inline bool operator==(const iterator& o) const {return __range == o.__range;}
+            inline bool operator!=(const iterator& o) const {return __range != o.__range;}
+
+        private:
+            friend struct row_range_t;
+            explicit iterator(row_range_t* range): __range(range), __kept() {}
+
+            row_range_t* __range;   //!< range being read, null for the end iterator
+            std::shared_ptr<const row_t> __kept;    //!< row returned by it++, null when the row of the range is
+        };
+
+        ~row_range_t()
+        {
+            /* a row left incomplete must not leak into the next parse */
+            __parser->__record.clear();
+        }
+
+        //!< @brief iterator on the current row. The first call reads the first row, later ones read nothing
+        iterator begin()
+        {
+            if(!__started)
+            {
+                __started = true;
+                __done = !next();
+            }
+            return __done ? iterator() : iterator(this);
+        }
+        //!< @brief end iterator
+        inline iterator end() const {return iterator();}
+
+    private:
+        friend struct csv_parser_t;
+
+        csv_parser_t*                   __parser;   //!< parser building the rows
+        auto_file_source_t              __file;     //!< read file, unopened when reading a stream
+        std::unique_ptr<stream_source_t> __stream;  //!< read stream, null when reading a file
+        timed_source_t<__stats_t>       __timed;    //!< source of __reader, timing the reads
+        block_reader_t                  __reader;   //!< input lines
+        detail::line_sampler_t          __sampler;  //!< limits and sampling of the parser
+        int                             __line;     //!< line number of the current row
+        bool                            __started;  //!< was the first row read?
+        bool                            __done;     //!< was the end of input reached?
+
+        /* rows of a file, none if it can not be opened */
+        row_range_t(csv_parser_t& parser, const std::string& fn):
+              __parser(&parser)
+            , __file()
+            , __stream()
+            , __timed(__file, parser.__stats)
+            , __reader(__timed)
+            , __sampler(parser.sampler())
+            , __line(0)
+            , __started(false)
+            , __done(false)
+        {
+            parser.lineno = 0;
+            parser.__input_failed = false;
+            __file.open(fn);
+        }
+
+        /* rows of a stream, numbered from the current lineno */
+        row_range_t(csv_parser_t& parser, std::istream& in):
+              __parser(&parser)
+            , __file()
+            , __stream(new stream_source_t(in))
+            , __timed(*__stream, parser.__stats)
+            , __reader(__timed)
+            , __sampler(parser.sampler())
+            , __line(0)
+            , __started(false)
+            , __done(false)
+        {
+            parser.__input_failed = false;
+        }
+
+        /* build the next row, false at end of input */
+        bool next()
+        {
+            if(__done || !__parser->next_row(__reader, __timed, __line, __sampler))
+            {
+                __done = true;
+                __parser->__input_failed = __file.failed();
+                return false;
+            }
+            __parser->__stats.count(&parse_stats_t::rows);
+            return true;
+        }
+
+        row_range_t(const row_range_t& o):
+              __parser(o.__parser)
+            , __file()
+            , __stream()
+            , __timed(__file, o.__parser->__stats)
+            , __reader(__timed)
+            , __sampler(o.__sampler)
+            , __line(0)
+            , __started(true)
+            , __done(true)
+        {GO_UNREACHABLE();}
+        const row_range_t& operator=(const row_range_t&) {GO_UNREACHABLE(); return *this;}
+    };
+
+    int min_useful_columns;              //!< minimum columns to consider. Any line having less than this threshold are ignored.
+    int lineno;                          //!< current line number
+
+
+    /** \brief default construct
+     * \param [in] mc: minimal useful columns, raised to the number of schema columns if any
+     */
+    csv_parser_t(int mc =0):
+          min_useful_columns(std::max(mc, (int)__schema::columns))
+        , lineno (0)
+        , __current()
+        , __feed_row()
+        , __carry()
+        , __feed_callback()
+        , __record()
+        , __record_line(0)
+        , __projection()
+        , __limits()
+        , __index_stride(0)
+        , __index()
+        , __indexed_file()
+        , __stats()
+        , __dictionaries()
+        , __input_failed(false)
+        {
+        }
+
+    /** \brief statistics of the parses since construction or the last reset_stats()
+     * every parse adds to them, whatever its entry point. Always zero with no_stats_t.
+     */
+    parse_stats_t stats() const {return __stats.snapshot();}
+
+    //!< @brief zero the statistics
+    void reset_stats() {__stats.reset();}
+
+    /** \brief was the compressed input of the last each_row (or rows range, once read to its end) corrupted or
+     * truncated? The rows decompressed before the damage are still delivered, the rest of the file is lost.
+     * Always false for plain files and streams.
+     */
+    inline bool failed() const {return __input_failed;}
+
+    /** \brief make each_row only materialize some columns, and drop rows on a key column before building them
+     * row fields then hold the projected columns only, in the given order. Lines not holding every projected
+     * column, or the key column, are ignored like the ones having less than min_useful_columns columns.
+     * The predicate sees the key column straight from the read buffer: rejected lines are never copied.
+     * each_view_row, each_record and the parallel and incremental parses are not affected.
+     * \param [in] columns: needed column indices, empty for every column. Negative indices are dropped
+     * \param [in] key_column: column given to the predicate, a negative one is taken as 0
+     * \param [in] predicate: rows whose key column is rejected are dropped, null to keep every row
+     * \example set_projection({3, 17}, 0, [](std::string_view key){return key == "EUR";})
+     */
+    void set_projection(const std::vector<int>& columns, int key_column = 0
+                        , const std::function<bool(std::string_view)>& predicate = nullptr)
+    {
+        __projection.columns.clear();
+        std::copy_if(columns.begin(), columns.end(), std::back_inserter(__projection.columns), [](int c){return c >= 0;});
+        __projection.key_column = std::max(key_column, 0);
+        __projection.predicate = predicate;
+    }
+
+    //!< @brief make each_row materialize every column of every row again
+    void clear_projection() {__projection = projection_t();}
+
+    /** \brief skip the first lines of the input, and stop after some rows
+     * skipped lines are only searched for their end of line: they are neither split nor counted as rows. Line
+     * numbers still count them. Limits apply to each_row, rows, each_view_row and each_view_row_batch.
+     * \param [in] skip_lines: lines to skip, a header for instance
+     * \param [in] max_rows: the parse stops once this many rows are delivered, 0 for no limit
+     * \example set_limits(1, 100) // the first 100 rows after a header
+     */
+    void set_limits(int skip_lines, int max_rows = 0)
+    {
+        __limits.skip_lines = std::max(skip_lines, 0);
+        __limits.max_rows = std::max(max_rows, 0);
+    }
+
+    /** \brief split only a sample of the lines, the other ones being skipped at end of line search speed
+     * lines are sampled before being split: comment, empty and short lines take part in the sampling, and with
+     * a quote character, a sampled out line can not start a field holding end of lines. Every parse samples
+     * the same lines again.
+     * \param [in] stride: keep one line out of stride, 1 to keep all
+     * \param [in] rate: keep each (stride kept) line with this probability, 1 to keep all
+     * \param [in] seed: seed of the random sampling
+     * \example set_sampling(1, 0.01) // about 1% of the lines, picked at random
+     */
+    void set_sampling(int stride, double rate = 1.0, uint64_t seed = 0)
+    {
+        __limits.stride = std::max(stride, 1);
+        __limits.rate = std::min(std::max(rate, 0.0), 1.0);
+        __limits.seed = seed;
+    }
+
+    //!< @brief read and deliver every line of the input again
+    void clear_limits() {__limits = limits_t();}
+
+    //!< @brief current limits and sampling
+    inline const limits_t& limits() const {return __limits;}
+
+    /** \brief make each_row intern some columns instead of copying them
+     * each distinct value of an interned column is stored once, in the dictionary of its column, and numbered:
+     * row_t::id gives the number of a row value, and row_t::interned its dictionary string, valid as long as the
+     * dictionary is. Interned fields are left empty in row_t::fields. Ids are dense and follow the first
+     * appearance of each value, so they can index plain arrays; they are kept from parse to parse until the
+     * columns are set again. Columns are file column indices, also with a projection.
+     * Copies of the parser share its dictionaries, which are not synchronized: such copies must not parse at the
+     * same time. each_view_row and the other entry points are not affected.
+     * \param [in] columns: interned column indices, empty to stop interning
+     * \example set_interned_columns({2, 5}); each_row(fn, [](const row_t& row, int){counts[row.id(2)]++;})
+     */
+    void set_interned_columns(const std::vector<int>& columns)
+    {
+        if(columns.empty())
+        {
+            __dictionaries.reset();
+            return;
+        }
+        __dictionaries = std::make_shared<column_dictionaries_t>();
+        __dictionaries->reset(columns);
+    }
+
+    /** \brief dictionary of an interned column: its distinct values, indexed by id
+     * \param [in] column: file column index
+     * \return an empty dictionary if the column is not interned
+     */
+    const string_pool_t& dictionary(int column) const
+    {
+        static const column_dictionaries_t none;
+        return (__dictionaries ? *__dictionaries : none).pool(column < 0 ? SIZE_MAX : column);
+    }
+
+    /** \brief use sidecar line indexes for random access into files
+     * once enabled, each_row(fn, callback) builds the index of a file while parsing it, when the file has no
+     * valid index yet, and saves it next to the file (see line_index_t::sidecar). The index is then used by
+     * seek_line, each_row over a range of lines, and each_view_row_parallel to cut chunks at indexed lines.
+     * An index is only used while the file size and modification time match the ones it was built from.
+     * \param [in] stride: lines between two index entries, 0 disables indexes
+     */
+    void set_line_index(int stride = line_index_t::default_stride)
+    {
+        __index_stride = std::max(stride, 0);
+        __indexed_file.clear();
+    }
+
+    /** \brief iterates over file lines, and call user function back
+     * the user callback function receives two parameters:
+     *     - the current row
+     *     - the current line number in input file
+     * Then, it has to do its own process. gzip and zstd files are detected from their first bytes, and
+     * decompressed by a separate thread while they are parsed.
+     * The callback may be any callable (it is then inlined into the parsing loop), a std::function, or nullptr.
+     * A callback returning bool stops the parse by returning true, as opt_parser_t callbacks do: the rest of
+     * the file is not read. Lines are skipped, sampled and limited as set by set_limits and set_sampling.
+     * \param [in] fn: filename
+     * \param [in] callback: user callback
+     * \return number of valid csv lines
+     * \example each_row(std::cin, [](const row_t&, int lineno){do something})
+     */
+    template <class fn_t>
+    int each_row(const std::string&fn, fn_t&& callback)
+    {
+        auto_file_source_t file;
+        lineno = 0;
+        __input_failed = false;
+        if(!file.open(fn))
+            return 0;
+        timed_source_t<__stats_t> timed(file, __stats);
+        block_reader_t reader(timed);
+        if(!__index_stride || file.compression() != COMPRESSION_NONE || line_index_for(fn))
+        {
+            const int parsed = each_row(reader, timed, callback);
+            __input_failed = file.failed();
+            return parsed;
+        }
+
+        __index.reset(__index_stride);
+        __indexed_file.clear();
+        int parsed = each_row(reader, timed, callback, &__index);
+        /* a parse stopped by its callback or its limits has not seen every line: its index would be short */
+        char* rest;
+        size_t length;
+        if(!reader.next_line(rest, length) && __index.complete(fn, lineno))
+        {
+            __indexed_file = fn;
+            __index.save(line_index_t::sidecar(fn));
+        }
+        return parsed;
+    }
+
+    /** \brief iterates over a range of file lines, and call user function back
+     * lines before first_line are skipped without being split. With a valid line index (see set_line_index),
+     * reading starts at the nearest indexed line instead of the beginning of the file.
+     * \param [in] fn: filename
+     * \param [in] first_line: first line to parse, from 1
+     * \param [in] last_line: last line to parse, included
+     * \param [in] callback: user callback
+     * \return number of valid csv lines in the range
+     * \example each_row("f.csv", 10000000, 10000100, [](const row_t&, int lineno){do something})
+     */
+    template <class fn_t>
+    int each_row(const std::string&fn, int first_line, int last_line, fn_t&& callback)
+    {
+        auto_file_source_t file;
+        lineno = 0;
+        __input_failed = false;
+        if(first_line > last_line || !file.open(fn))
+            return 0;
+        seek_near(fn, file, first_line);
+        timed_source_t<__stats_t> timed(file, __stats);
+        block_reader_t reader(timed);
+        const int parsed = each_row(reader, timed, callback, nullptr, first_line, last_line);
+        __input_failed = file.failed();
+        return parsed;
+    }
+
+    /** \brief find where a line starts
+     * with a valid line index (see set_line_index), only the lines after the nearest indexed one are read.
+     * \param [in] fn: filename
+     * \param [in] line: wanted line, from 1
+     * \return byte offset of the line in the file, -1 if the file can not be read or has less lines
+     */
+    long long seek_line(const std::string&fn, int line)
+    {
+        auto_file_source_t file;
+        lineno = 0;
+        if(line < 1 || !file.open(fn))
+            return -1;
+        const uint64_t base = seek_near(fn, file, line);
+        block_reader_t reader(file);
+        char* text;
+        size_t length;
+        while(lineno + 1 < line && reader.next_line(text, length))
+            lineno++;
+        const size_t offset = reader.offset();
+        if(lineno + 1 != line || !reader.next_line(text, length))
+            return -1;
+        return (long long)(base + offset);
+    }
+
+    /** \brief iterates over file lines without copying them, and call user function back
+     * the file is memory mapped, and each row exposes its fields as std::string_view pointing
+     * into the mapping: no per line nor per field allocation happens. Fields are only valid
+     * during the callback. As with each_row, the callback may be any callable, a std::function, or nullptr.
+     * \param [in] fn: filename
+     * \param [in] callback: user callback
+     * \return number of valid csv lines
+     * \example each_view_row("some_file.csv", [](const view_row_t&, int lineno){do something})
+     */
+    template <class fn_t>
+    int each_view_row(const std::string&fn, fn_t&& callback)
+    {
+        mapped_file_t file;
+        lineno = 0;
+        if(!open_mapped(file, fn))
+            return 0;
+
+        view_row_t current;
+        detail::line_sampler_t sampler = this->sampler();
+        const int parsed = scan_lines(file.data(), file.end(), lineno, current, [this, &callback](const view_row_t& row, int line)
+        {
+            bool stop = false;
+            measure(__stats, &parse_stats_t::callback_ns, [&]{stop = detail::call_back(callback, row, line);});
+            return stop;
+        }, __stats, &sampler);
+        __stats.count(&parse_stats_t::rows, parsed);
+        return parsed;
+    }
+
+    static const size_t default_batch_size = 1024;   //!< rows per batch of each_view_row_batch
+
+    /** \brief iterates over file lines without copying them, and call user function back once per batch of rows
+     * the file is memory mapped, as with each_view_row, and rows are gathered into a row_batch_t which is handed
+     * to the callback once it holds batch_size rows, and once more with the remaining rows at the end. The batch
+     * storage is reused: once the widest batch is met, nothing is allocated. Fields stay valid until the parse
+     * returns, so a callback may keep them across batches. A callback returning true stops the parse.
+     * \param [in] fn: filename
+     * \param [in] callback: user callback, receiving a const row_batch_t&
+     * \param [in] batch_size: rows per batch
+     * \return number of valid csv lines
+     * \example each_view_row_batch("some_file.csv", [](const row_batch_t& batch){for(size_t r=0; r < batch.size(); ++r) batch.field(r, 2);})
+     */
+    template <class fn_t>
+    int each_view_row_batch(const std::string&fn, fn_t&& callback, size_t batch_size = default_batch_size)
+    {
+        mapped_file_t file;
+        lineno = 0;
+        if(!open_mapped(file, fn))
+            return 0;
+
+        batch_size = std::max(batch_size, (size_t)1);
+        row_batch_t batch;
+        batch.lines.reserve(batch_size);
+        batch.ends.reserve(batch_size);
+        batch.fields.reserve(batch_size * std::max(min_useful_columns, 1));
+        auto deliver = [this, &callback, &batch]
+        {
+            bool stop = false;
+            measure(__stats, &parse_stats_t::callback_ns, [&]{stop = detail::call_back(callback, std::as_const(batch));});
+            batch.clear();
+            return stop;
+        };
+        view_row_t current;
+        detail::line_sampler_t sampler = this->sampler();
+        bool stopped = false;
+        const int parsed = scan_lines(file.data(), file.end(), lineno, current, [this, &batch, &deliver, &stopped, batch_size]
+                                      (const view_row_t& row, int line)
+        {
+            measure(__stats, &parse_stats_t::materialize_ns, [&]{batch.push_back(row.fields, line);});
+            if(batch.size() == batch_size)
+                stopped = deliver();
+            return stopped;
+        }, __stats, &sampler);
+        if(!batch.empty() && !stopped)
+            deliver();
+        __stats.count(&parse_stats_t::rows, parsed);
+        return parsed;
+    }
+
+    /** \brief iterates over file lines, and call user function back with columns converted to the schema types
+     * the file is memory mapped and columns are converted straight from it. A line whose columns can not be
+     * converted is not delivered: on_error receives its line and column instead, nothing is thrown.
+     * Columns beyond the schema ones are ignored.
+     * \param [in] fn: filename
+     * \param [in] callback: user callback, receiving the converted record and its line number
+     * \param [in] on_error: called for each line that can not be converted, may be null
+     * \return number of converted lines
+     * \example csv_parser_t<';','#',schema_t<int,double>>().each_record("f.csv", [](const std::tuple<int,double>&, int lineno){})
+     */
+    int each_record(const std::string&fn, const std::function<void(const record_t&,int)>& callback
+                    , const std::function<void(const parse_error_t&)>& on_error = nullptr)
+    {
+        static_assert(__schema::columns > 0, "each_record needs a schema_t");
+        mapped_file_t file;
+        lineno = 0;
+        if(!open_mapped(file, fn))
+            return 0;
+
+        const int converted = scan_records(file.data(), file.end(), lineno, [this, &callback](const record_t& record, int line)
+        {
+            measure(__stats, &parse_stats_t::callback_ns, [&]
+            {
+                if(callback)
+                    callback(record, line);
+            });
+        }, on_error, __stats);
+        __stats.count(&parse_stats_t::rows, converted);
+        return converted;
+    }
+
+    /** \brief same as each_record, with each record brace-initializing a user struct
+     * \param [in] fn: filename
+     * \param [in] callback: user callback, receiving the user struct and its line number
+     * \param [in] on_error: called for each line that can not be converted, may be null
+     * \return number of converted lines
+     * \example struct point_t {int x; double y;}; each_record_as<point_t>("f.csv", [](const point_t&, int lineno){})
+     */
+    template <class user_t>
+    int each_record_as(const std::string&fn, const std::function<void(const user_t&,int)>& callback
+                       , const std::function<void(const parse_error_t&)>& on_error = nullptr)
+    {
+        return each_record(fn, [&callback](const record_t& record, int line)
+        {
+            if(callback)
+                callback(std::apply([](const auto&... columns){return user_t{columns...};}, record), line);
+        }, on_error);
+    }
+
+    typedef column_table_t<__schema> table_t;   //!< column-major storage of a whole file
+
+    /** \brief load a whole file into column-major storage
+     * with a schema, numeric columns are stored in contiguous arrays and string columns in one character arena
+     * per column; lines that can not be converted are reported to on_error and skipped. Without schema, the first
+     * min_useful_columns columns of each valid line are stored as strings.
+     * \param [in] fn: filename
+     * \param [in] on_error: called for each line that can not be converted, may be null
+     * \return the loaded table, empty if the file can not be read
+     * \example auto table = csv_parser_t<';','#',schema_t<int,double>>().load_columns("f.csv"); table.column<1>()
+     */
+    table_t load_columns(const std::string&fn, const std::function<void(const parse_error_t&)>& on_error = nullptr)
+    {
+        table_t table;
+        mapped_file_t file;
+        lineno = 0;
+        if(!open_mapped(file, fn))
+            return table;
+
+        int rows;
+        if constexpr (__schema::columns > 0)
+        {
+            rows = scan_records(file.data(), file.end(), lineno, [this, &table](const record_t& record, int line)
+            {
+                measure(__stats, &parse_stats_t::materialize_ns, [&]{table.push_back(record, line);});
+            }, on_error, __stats);
+        }
+        else
+        {
+            table.columns.resize(std::max(min_useful_columns, 0));
+            view_row_t current;
+            std::string scratch;
+            rows = scan_lines(file.data(), file.end(), lineno, current, [this, &table, &scratch](const view_row_t& row, int line)
+            {
+                measure(__stats, &parse_stats_t::materialize_ns, [&]
+                {
+                    for(size_t c=0; c < table.columns.size(); ++c)
+                        table.columns[c].push_back(row.unquoted(c, scratch));
+                    table.lines.push_back(line);
+                });
+            }, __stats);
+        }
+        __stats.count(&parse_stats_t::rows, rows);
+        return table;
+    }
+
+    /** \brief callback delivery policy of each_view_row_parallel
+     */
+    enum delivery_t
+    {
+        UNORDERED,  //!< rows are delivered by the workers, concurrently and in no particular order
+        IN_ORDER    //!< rows are delivered by the calling thread, in file order, through a reorder buffer
+    };
+
+    /** \brief iterates over file lines using several threads, and call user function back
+     * the memory mapped file is cut into chunks at end of line boundaries, and the chunks are parsed by a pool of
+     * threads. Line numbers are the same as each_view_row ones: with IN_ORDER, they are made absolute while rows are
+     * delivered; with UNORDERED, end of lines are counted per chunk first, then prefix summed. With a valid line
+     * index (see set_line_index), chunks start at indexed lines, whose numbers are known: nothing is counted.
+     * With UNORDERED, the callback is called from several threads at the same time and has to be thread safe.
+     * With IN_ORDER, at most 2 chunks per thread are kept parsed ahead of the delivery.
+     * \param [in] fn: filename
+     * \param [in] callback: user callback
+     * \param [in] delivery: callback delivery policy
+     * \param [in] threads: number of parsing threads, 0 means one per hardware thread
+     * \return number of valid csv lines
+     */
+    int each_view_row_parallel(const std::string&fn,const std::function<void(const view_row_t&,int)>& callback
+                               , delivery_t delivery = IN_ORDER, int threads = 0)
+    {
+        mapped_file_t file;
+        lineno = 0;
+        if(!open_mapped(file, fn))
+            return 0;
+
+        thread_pool_t pool(threads);
+        std::vector<int> first_line;
+        std::vector<const char*> bounds = line_index_for(fn)
+                                        ? split_indexed_chunks(file.data(), file.end(), (size_t)pool.size() * 4, first_line)
+                                        : split_chunks(file.data(), file.end(), (size_t)pool.size() * 4);
+        const int chunks = (int)bounds.size() - 1;
+        return delivery == IN_ORDER ? parallel_in_order(pool, bounds, chunks, callback)
+                                    : parallel_unordered(pool, bounds, chunks, callback, std::move(first_line));
+    }
+
+    /** \brief iterates over stream lines, and call user function back
+     * the user callback function receives two parameters:
+     *     - the current row
+     *     - the current line number in input file
+     * Then, it has to do its own process. Line numbers continue from the current lineno.
+     * \param [in] in: input stream
+     * \param [in] callback: user callback
+     * \return number of valid csv lines
+     * \example each_row(std::cin, [](const row_t&, int lineno){do something})
+     */
+    template <class fn_t>
+    int each_row(std::istream& in, fn_t&& callback)
+    {
+        __input_failed = false;
+        stream_source_t stream(in);
+        timed_source_t<__stats_t> timed(stream, __stats);
+        block_reader_t reader(timed);
+        return each_row(reader, timed, callback);
+    }
+
+    /** \brief rows of a file, as a lazy input range
+     * rows are the ones each_row would deliver, but the caller pulls them: the file is read by blocks as the
+     * iteration moves forward, and stopping the iteration stops the parse. gzip and zstd files are detected
+     * as with each_row. Only one range (or parse) may use the parser at a time. The range can not be copied
+     * nor moved: keep it in a variable, or iterate the returned temporary directly.
+     * \param [in] fn: filename
+     * \return rows of the file, an empty range if it can not be opened
+     * \example for(const auto& row : parser.rows("f.csv")) {if(row[0] == "stop") break;}
+     */
+    row_range_t rows(const std::string& fn)
+    {
+        return row_range_t(*this, fn);
+    }
+
+    /** \brief rows of a stream, as a lazy input range
+     * the same as rows(filename), reading an already opened stream. Line numbers continue from the current lineno.
+     * \param [in] in: input stream, must outlive the range
+     * \return rows of the stream
+     */
+    row_range_t rows(std::istream& in)
+    {
+        return row_range_t(*this, in);
+    }
+
+    /** \brief start an incremental parse, fed by chunks of any size through feed()
+     * the previous incremental parse, if any, is dropped, and line numbering restarts.
+     * \param [in] callback: user callback, called by feed() and finish() for each valid csv line.
+     * Fields point into the buffer given to feed(), and are only valid during the callback.
+     */
+    void start_feed(const std::function<void(const view_row_t&,int)>& callback)
+    {
+        lineno = 0;
+        __carry.clear();
+        __feed_callback = callback;
+    }
+
+    /** \brief parse the complete lines of the next chunk of input
+     * complete lines are parsed straight from data. Only the trailing incomplete line is kept (copied) until
+     * the chunk completing it is fed.
+     * \param [in] data: next input bytes
+     * \param [in] size: number of bytes
+     * \return number of valid csv lines found
+     */
+    int feed(const char* data, size_t size)
+    {
+        __stats.count(&parse_stats_t::bytes_read, size);
+        const char* end = data + size;
+        int parsed = 0;
+        if(!__carry.empty())
+        {
+            const char* nl = static_cast<const char*>(memchr(data, '\n', size));
+            if(!nl)
+            {
+                __carry.append(data, size);
+                return 0;
+            }
+            __carry.append(data, nl + 1 - data);
+            parsed += scan_lines(__carry.data(), __carry.data() + __carry.size(), lineno, __feed_row, deliver_fed(), __stats);
+            __carry.clear();
+            data = nl + 1;
+        }
+        const char* complete = end;
+        while(complete > data && complete[-1] != '\n')
+            --complete;
+        if(complete > data)
+        {
+            parsed += scan_lines(data, complete, lineno, __feed_row, deliver_fed(), __stats);
+            data = complete;
+        }
+        __carry.append(data, end - data);
+        return parsed;
+    }
+
+    /** \brief end an incremental parse: parse the last line if it has no end of line
+     * \return number of valid csv lines found (0 or 1)
+     */
+    int finish()
+    {
+        int parsed = scan_lines(__carry.data(), __carry.data() + __carry.size(), lineno, __feed_row, deliver_fed(), __stats);
+        __carry.clear();
+        return parsed;
+    }
+
+private:
+    row_t __current;                     //!< row reused by each_row for every line
+    view_row_t __feed_row;               //!< row reused by feed()
+    std::string __carry;                 //!< incomplete line left by the last feed()
+    std::function<void(const view_row_t&,int)> __feed_callback;    //!< callback of the incremental parse
+    std::string __record;                //!< lines of a row whose quoted field holds end of lines
+    int __record_line;                   //!< first line of __record
+    projection_t __projection;           //!< columns and rows each_row keeps
+    limits_t __limits;                   //!< skipped lines, sampling and rows limit of the parses
+    int __index_stride;                  //!< line index stride, 0 when line indexes are not used
+    line_index_t __index;                //!< line index of __indexed_file
+    std::string __indexed_file;          //!< file described by __index, empty if none
+    __stats_t __stats;                   //!< statistics of the parses since the last reset_stats()
+    std::shared_ptr<column_dictionaries_t> __dictionaries;  //!< dictionaries of the interned columns, null if none. Shared by copies, not synchronized
+    bool __input_failed;                 //!< the compressed input of the last read parse was corrupted or truncated
+
+    /** \brief iterates over the lines of a reader, and call user function back
+     * \param [in,out] reader: input lines, following line lineno
+     * \param [in] timed: source of the reader, telling the time spent reading
+     * \param [in] callback: user callback
+     * \param [in,out] index: line index to fill with the read lines, may be null
+     * \param [in] first_line: lines before this one are skipped without being split
+     * \param [in] last_line: reading stops after this line
+     * \return number of valid csv lines
+     */
+    template <class fn_t>
+    int each_row(block_reader_t& reader, const timed_source_t<__stats_t>& timed, fn_t& callback
+                 , line_index_t* index = nullptr, int first_line = 1, int last_line = INT_MAX)
+    {
+        int parsed=0;
+        int row_line;
+        bool stop = false;
+        detail::line_sampler_t sampler = this->sampler();
+        while(!stop && next_row(reader, timed, row_line, sampler, index, first_line, last_line))
+        {
+            measure(__stats, &parse_stats_t::callback_ns, [&]{stop = detail::call_back(callback, __current, row_line);});
+            parsed++;
+        }
+        __stats.count(&parse_stats_t::rows, parsed);
+        return parsed;
+    }
+
+    /** \brief read lines until the next valid row, built into __current
+     * \param [in,out] reader: input lines, following line lineno
+     * \param [in] timed: source of the reader, telling the time spent reading
+     * \param [out] row_line: line number of the row, the first one of a row spanning several lines
+     * \param [in,out] sampler: lines to leave out, and rows to deliver
+     * \param [in,out] index: line index to fill with the read lines, may be null
+     * \param [in] first_line: lines before this one are skipped without being split
+     * \param [in] last_line: reading stops after this line
+     * \return false at end of input, after last_line, or once the sampler is full
+     */
+    bool next_row(block_reader_t& reader, const timed_source_t<__stats_t>& timed, int& row_line
+                  , detail::line_sampler_t& sampler
+                  , line_index_t* index = nullptr, int first_line = 1, int last_line = INT_MAX)
+    {
+        char* line;
+        size_t length;
+        for(;;)
+        {
+            const size_t offset = reader.offset();
+            const uint64_t since = __stats.clock();
+            const uint64_t io = timed.elapsed();
+            if(lineno >= last_line || sampler.full() || !reader.next_line(line, length))
+                break;
+            /* reads are io time, not scan time */
+            __stats.time(&parse_stats_t::scan_ns, since + (timed.elapsed() - io));
+            lineno++;
+            __stats.count(&parse_stats_t::lines);
+            if(index)
+                index->add(lineno, offset);
+            if(lineno < first_line || (__record.empty() && sampler.skip(lineno)))
+                continue;
+            const char* first = line;
+            const char* last = line + length;
+            row_line = lineno;
+            size_t resume = 0;
+            if constexpr (__quote != 0)
+            {
+                if(!__record.empty())
+                {
+                    resume = __record.size();
+                    __record.push_back('\n');
+                    __record.append(line, length);
+                    first = __record.data();
+                    last = first + __record.size();
+                    row_line = __record_line;
+                }
+            }
+            const bool valid = build_row(first, last, resume);
+            if constexpr (__quote != 0)
+            {
+                if(__current.open_quote())
+                {
+                    if(__record.empty())
+                    {
+                        __record.assign(line, length);
+                        __record_line = lineno;
+                    }
+                    continue;
+                }
+                __record.clear();
+            }
+            if(valid)
+            {
+                sampler.delivered();
+                return true;
+            }
+        }
+        if(__record.empty())
+            return false;
+        /* unterminated quote: the rest of the input is its row */
+        const bool valid = build_row(__record.data(), __record.data() + __record.size());
+        row_line = __record_line;
+        __record.clear();
+        if(valid)
+            sampler.delivered();
+        return valid;
+    }
+
+    //!< @brief sampler following __limits, for one parse
+    inline detail::line_sampler_t sampler() const
+    {
+        return detail::line_sampler_t(__limits.skip_lines, __limits.max_rows, __limits.stride, __limits.rate
+                                      , __limits.seed);
+    }
+
+    /** \brief split a line into __current, applying the projection if any
+     * \param [in] first: first character of the line
+     * \param [in] last: one past the last character of the line
+     * \param [in] resume: 0, or the length of a record already scanned up to an end of line between quotes: only
+     * the following bytes are scanned, and the row is only built once its quoted field is closed
+     * \return true if the row is valid
+     */
+    bool build_row(const char* first, const char* last, size_t resume = 0)
+    {
+        uint64_t since = __stats.clock();
+        const char* stop = resume ? __current.resume_scan(first, first + resume, last) : __current.scan(first, last);
+        __stats.time(&parse_stats_t::scan_ns, since);
+        if(resume && __current.open_quote())
+            return false;
+        since = __stats.clock();
+        column_dictionaries_t* dictionaries = __dictionaries.get();
+        const bool valid = __projection.empty()
+                         ? __current.fill(first, stop, dictionaries).size() >= min_useful_columns
+                         : __current.fill(first, stop, __projection, min_useful_columns, dictionaries);
+        __stats.time(&parse_stats_t::materialize_ns, since);
+        if(!valid && !__current.open_quote())
+            count_dropped(__stats, first, stop, last);
+        return valid;
+    }
+
+    /** \brief count a line which is not delivered, as a comment, empty or rejected line
+     * \param [in,out] stats: statistics to update
+     * \param [in] first: first character of the line
+     * \param [in] stop: comment starter or end of line which stopped the scan
+     * \param [in] last: one past the last character of the buffer
+     */
+    static void count_dropped(__stats_t& stats, const char* first, const char* stop, const char* last)
+    {
+        if constexpr (__stats_t::enabled)
+        {
+            if(stop != first)
+                stats.count(&parse_stats_t::rejected_rows);
+            else if(stop < last && *stop == __comment_starter)
+                stats.count(&parse_stats_t::comment_lines);
+            else
+                stats.count(&parse_stats_t::empty_lines);
+        }
+    }
+
+    /** \brief call fn, adding the time it takes to a timer
+     * \param [in,out] stats: statistics to update
+     * \param [in] timer: timer to add to
+     * \param [in] fn: function to time
+     */
+    template <class fn_t>
+    static void measure(__stats_t& stats, uint64_t parse_stats_t::* timer, fn_t&& fn)
+    {
+        const uint64_t since = stats.clock();
+        fn();
+        stats.time(timer, since);
+    }
+
+    /** \brief memory map a file, counting its size as read bytes and the mapping as io time
+     * \param [out] file: file to open
+     * \param [in] fn: filename
+     * \return true on success
+     */
+    bool open_mapped(mapped_file_t& file, const std::string&fn)
+    {
+        const uint64_t since = __stats.clock();
+        if(!file.open(fn))
+            return false;
+        __stats.time(&parse_stats_t::io_ns, since);
+        __stats.count(&parse_stats_t::bytes_read, file.size());
+        return true;
+    }
+
+    /** \brief make __index describe a file, loading its sidecar index if needed
+     * \param [in] fn: filename
+     * \return true if line indexes are used and the file has a valid one
+     */
+    bool line_index_for(const std::string&fn)
+    {
+        if(!__index_stride)
+            return false;
+        if(__indexed_file == fn && __index.valid_for(fn))
+            return true;
+        __indexed_file.clear();
+        if(!__index.load(line_index_t::sidecar(fn)) || !__index.valid_for(fn))
+            return false;
+        __indexed_file = fn;
+        return true;
+    }
+
+    /** \brief move a file to the nearest indexed line at or before a line, and set lineno to the line before it
+     * \param [in] fn: filename
+     * \param [in,out] file: opened file
+     * \param [in] line: wanted line
+     * \return offset of the new file position
+     */
+    uint64_t seek_near(const std::string&fn, auto_file_source_t& file, int line)
+    {
+        int indexed_line;
+        uint64_t offset;
+        if(!line_index_for(fn) || !__index.locate(line, indexed_line, offset) || !file.seek(offset))
+            return 0;
+        lineno = indexed_line - 1;
+        return offset;
+    }
+
+    /** \brief parse the lines of a buffer, and call fn(row, line) for each valid csv line
+     * \param [in] it: first character of the first line
+     * \param [in] end: one past the last character of the buffer
+     * \param [in,out] line: number of the line preceding the buffer, receives the last line number
+     * \param [in,out] current: row used to hold fields
+     * \param [in] fn: row handler. When it returns bool, true stops the scan
+     * \param [in,out] stats: receives lines, dropped lines and scan time, rows and fn time are left to the caller
+     * \param [in,out] sampler: lines to leave out, and rows to deliver, null to split every line
+     * \return number of valid csv lines
+     */
+    template <class fn_t>
+    int scan_lines(const char* it, const char* end, int& line, view_row_t& current, fn_t&& fn
+                   , __stats_t& stats, detail::line_sampler_t* sampler = nullptr) const
+    {
+        int parsed = 0;
+        const int start = line;
+        while(it < end)
+        {
+            const uint64_t since = stats.clock();
+            if(sampler)
+            {
+                if(sampler->full())
+                    break;
+                if(sampler->skip(line + 1))
+                {
+                    const char* eol = static_cast<const char*>(memchr(it, '\n', end - it));
+                    it = eol ? eol + 1 : end;
+                    line++;
+                    stats.time(&parse_stats_t::scan_ns, since);
+                    continue;
+                }
+            }
+            const char* stop = current.scan(it, end);
+            const char* eol = stop;
+            if(eol < end && *eol != '\n')
+            {
+                eol = static_cast<const char*>(memchr(eol, '\n', end - eol));
+                if(!eol)
+                    eol = end;
+            }
+            const int row_line = ++line;
+            if constexpr (__quote != 0)
+            {
+                for(const char* nl = it; (nl = static_cast<const char*>(memchr(nl, '\n', eol - nl))); ++nl)
+                    line++;
+            }
+            stats.time(&parse_stats_t::scan_ns, since);
+            if(current.size() < min_useful_columns)
+            {
+                count_dropped(stats, it, stop, end);
+                it = eol + 1;
+                continue;
+            }
+            it = eol + 1;
+            parsed++;
+            if(sampler)
+                sampler->delivered();
+            if(detail::invoke_callback(fn, current, row_line))
+                break;
+        }
+        stats.count(&parse_stats_t::lines, line - start);
+        return parsed;
+    }
+
+    /** \brief parse the lines of a buffer, and call fn(record, line) for each line converted to the schema types
+     * \param [in] first: first character of the first line
+     * \param [in] last: one past the last character of the buffer
+     * \param [in,out] line: number of the line preceding the buffer, receives the last line number
+     * \param [in] fn: record handler
+     * \param [in] on_error: called for each line that can not be converted, may be null
+     * \param [in,out] stats: receives lines, rejected lines, scan and conversion time
+     * \return number of converted lines
+     */
+    template <class fn_t>
+    int scan_records(const char* first, const char* last, int& line, fn_t&& fn
+                     , const std::function<void(const parse_error_t&)>& on_error, __stats_t& stats) const
+    {
+        int converted = 0;
+        view_row_t current;
+        view_row_t text;
+        std::array<std::string, __schema::columns> scratch;
+        record_t record;
+        scan_lines(first, last, line, current, [&](const view_row_t& row, int l)
+        {
+            parse_error_t error;
+            const uint64_t since = stats.clock();
+            const view_row_t* source = &row;
+            /* min_useful_columns may be lowered below the schema width: a short row has no value to convert */
+            if(row.size() < (int)__schema::columns)
+            {
+                stats.count(&parse_stats_t::rejected_rows);
+                if(on_error)
+                    on_error(parse_error_t{l, row.size(), std::errc::invalid_argument});
+                return;
+            }
+            if constexpr (__quote != 0)
+            {
+                text.fields.resize(__schema::columns);
+                for(size_t c=0; c < __schema::columns; ++c)
+                    text.fields[c] = row.unquoted(c, scratch[c]);
+                source = &text;
+            }
+            const bool valid = convert_row(*source, l, record, error, std::make_index_sequence<__schema::columns>());
+            stats.time(&parse_stats_t::materialize_ns, since);
+            if(!valid)
+            {
+                stats.count(&parse_stats_t::rejected_rows);
+                if(on_error)
+                    on_error(error);
+                return;
+            }
+            fn(record, l);
+            converted++;
+        }, stats);
+        return converted;
+    }
+
+    /** \brief convert the schema columns of a row
+     * \param [in] row: row to convert, with at least __schema::columns fields
+     * \param [in] line: row line number
+     * \param [out] record: converted columns
+     * \param [out] error: first column which failed, if any
+     * \return true if every column was converted
+     */
+    template <size_t... __index>
+    static bool convert_row(const view_row_t& row, int line, record_t& record, parse_error_t& error
+                            , std::index_sequence<__index...>)
+    {
+        std::errc code = std::errc();
+        int column = 0;
+        if(((code = convert_field(row.fields[__index], std::get<__index>(record)), column = __index
+            , code == std::errc()) && ...))
+            return true;
+        error = parse_error_t{line, column, code};
+        return false;
+    }
+
+    //!< @brief row handler of feed() and finish()
+    auto deliver_fed()
+    {
+        return [this](const view_row_t& row, int line)
+        {
+            measure(__stats, &parse_stats_t::callback_ns, [&]
+            {
+                if(__feed_callback)
+                    __feed_callback(row, line);
+            });
+            __stats.count(&parse_stats_t::rows);
+        };
+    }
+
+    /** \brief cut a buffer into about n chunks, each one starting at a line beginning
+     * \param [in] first: buffer begin
+     * \param [in] last: buffer end
+     * \param [in] n: wished number of chunks
+     * \return chunks boundaries, from first to last
+     */
+    static std::vector<const char*> split_chunks(const char* first, const char* last, size_t n)
+    {
+        const size_t min_chunk = 1 << 20;
+        size_t step = std::max((size_t)(last - first) / std::max(n, (size_t)1), min_chunk);
+        std::vector<const char*> bounds(1, first);
+        const char* it = first;
+        while((size_t)(last - it) > step)
+        {
+            const char* nl = static_cast<const char*>(memchr(it + step, '\n', last - it - step));
+            if(!nl || nl + 1 == last)
+                break;
+            it = nl + 1;
+            bounds.push_back(it);
+        }
+        bounds.push_back(last);
+        return bounds;
+    }
+
+    /** \brief cut a buffer into about n chunks at indexed lines of __index
+     * \param [in] first: buffer begin, the indexed file content
+     * \param [in] last: buffer end
+     * \param [in] n: wished number of chunks
+     * \param [out] first_line: number of the line preceding each chunk, and total number of lines last
+     * \return chunks boundaries, from first to last
+     */
+    std::vector<const char*> split_indexed_chunks(const char* first, const char* last, size_t n
+                                                  , std::vector<int>& first_line) const
+    {
+        const size_t min_chunk = 1 << 20;
+        const size_t size = last - first;
+        const size_t step = std::max(size / std::max(n, (size_t)1), min_chunk);
+        const std::vector<uint64_t>& offsets = __index.offsets();
+        std::vector<const char*> bounds(1, first);
+        first_line.assign(1, 0);
+        for(size_t e=1; e < offsets.size(); ++e)
+        {
+            if(offsets[e] >= size)
+                break;
+            if(offsets[e] - (bounds.back() - first) < step)
+                continue;
+            bounds.push_back(first + offsets[e]);
+            first_line.push_back((int)e * __index.stride());
+        }
+        bounds.push_back(last);
+        first_line.push_back(__index.lines());
+        return bounds;
+    }
+
+    /** \brief rows of one chunk, parsed ahead and waiting for delivery
+     */
+    struct parsed_chunk_t
+    {
+        std::vector<std::string_view>   fields;     //!< fields of all rows
+        std::vector<uint32_t>           ends;       //!< fields end index of each row
+        std::vector<int>                lines;      //!< line number of each row, relative to the chunk
+        int                             line_count; //!< number of lines in the chunk
+        __stats_t                       stats;      //!< statistics of the chunk parse
+        parsed_chunk_t(): fields(), ends(), lines(), line_count(0), stats() {}
+    };
+
+    int parallel_in_order(thread_pool_t& pool, const std::vector<const char*>& bounds, int chunks
+                          , const std::function<void(const view_row_t&,int)>& callback)
+    {
+        std::vector<parsed_chunk_t> parsed(chunks);
+        std::deque<std::future<void>> pending;
+        const int window = 2 * pool.size();
+        int submitted = 0;
+        int rows = 0;
+        view_row_t current;
+        try
+        {
+            for(int c=0; c < chunks; ++c)
+            {
+                for(; submitted < chunks && submitted < c + window; ++submitted)
+                {
+                    parsed_chunk_t* out = &parsed[submitted];
+                    const char* first = bounds[submitted];
+                    const char* last = bounds[submitted+1];
+                    pending.push_back(pool.submit([this, out, first, last]
+                    {
+                        view_row_t row;
+                        scan_lines(first, last, out->line_count, row, [out](const view_row_t& r, int line)
+                        {
+                            measure(out->stats, &parse_stats_t::materialize_ns, [&]
+                            {
+                                out->fields.insert(out->fields.end(), r.fields.begin(), r.fields.end());
+                                out->ends.push_back(out->fields.size());
+                                out->lines.push_back(line);
+                            });
+                        }, out->stats);
+                    }));
+                }
+                pending.front().get();
+                pending.pop_front();
+
+                parsed_chunk_t& chunk = parsed[c];
+                uint32_t begin = 0;
+                for(size_t r=0; r < chunk.ends.size(); ++r)
+                {
+                    current.fields.assign(chunk.fields.begin() + begin, chunk.fields.begin() + chunk.ends[r]);
+                    begin = chunk.ends[r];
+                    measure(__stats, &parse_stats_t::callback_ns, [&]
+                    {
+                        if(callback)
+                            callback(current, lineno + chunk.lines[r]);
+                    });
+                }
+                rows += chunk.ends.size();
+                __stats.merge(chunk.stats);
+                __stats.count(&parse_stats_t::rows, chunk.ends.size());
+                lineno += chunk.line_count;
+                chunk = parsed_chunk_t();
+            }
+        }
+        catch(...)
+        {
+            pool.wait();
+            throw;
+        }
+        return rows;
+    }
+
+    int parallel_unordered(thread_pool_t& pool, const std::vector<const char*>& bounds, int chunks
+                           , const std::function<void(const view_row_t&,int)>& callback
+                           , std::vector<int> first_line)
+    {
+        std::vector<std::future<void>> pending;
+        std::vector<__stats_t> stats(chunks);
+        const bool counted = !first_line.empty();
+        if(!counted)
+            first_line.assign(chunks + 1, 0);
+        for(int c=0; !counted && c < chunks; ++c)
+        {
+            const char* first = bounds[c];
+            const char* last = bounds[c+1];
+            int* out = &first_line[c+1];
+            __stats_t* st = &stats[c];
+            pending.push_back(pool.submit([first, last, out, st]
+            {
+                measure(*st, &parse_stats_t::scan_ns, [&]
+                {
+                    *out = std::count(first, last, '\n');
+                    if(last > first && last[-1] != '\n')
+                        ++*out;
+                });
+            }));
+        }
+        pool.wait();
+        for(auto& it : pending)
+            it.get();
+        pending.clear();
+        for(int c=0; !counted && c < chunks; ++c)
+            first_line[c+1] += first_line[c];
+
+        std::vector<int> rows(chunks, 0);
+        for(int c=0; c < chunks; ++c)
+        {
+            const char* first = bounds[c];
+            const char* last = bounds[c+1];
+            int* out = &rows[c];
+            int line = first_line[c];
+            __stats_t* st = &stats[c];
+            pending.push_back(pool.submit([this, first, last, out, line, st, &callback]() mutable
+            {
+                view_row_t row;
+                *out = scan_lines(first, last, line, row, [st, &callback](const view_row_t& r, int l)
+                {
+                    measure(*st, &parse_stats_t::callback_ns, [&]
+                    {
+                        if(callback)
+                            callback(r, l);
+                    });
+                }, *st);
+                st->count(&parse_stats_t::rows, *out);
+            }));
+        }
+        pool.wait();
+        for(auto& it : pending)
+            it.get();
+        for(const __stats_t& st : stats)
+            __stats.merge(st);
+        lineno = first_line[chunks];
+        return std::accumulate(rows.begin(), rows.end(), 0);
+    }
+
+};
+
+typedef csv_parser_t<';','#'> tranche_file_parser_t;    //!< tranche file parser
+typedef csv_parser_t<';','#'> format_file_parser_t;     //!< format file parser
+typedef csv_parser_t<';','#'> labels_file_parser_t;     //!< labels file parser
+typedef csv_parser_t<';','#'> generic_csv_parser_t;     //!< labels file parser
+typedef csv_parser_t<';','#',untyped_t,'"'> quoted_csv_parser_t; //!< csv parser with quoted fields
+/**
+* @} // addtogroup
+*/
+
+} /*namespace mparsers*/
+
+#endif // CSV_UTILS_HEADER
@@ -0,0 +1,100 @@
+#ifndef M_CSV_SCHEMA_HEADER
+#define M_CSV_SCHEMA_HEADER
+
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <system_error>
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file csv_schema.h
+ * \brief compile-time column types of a csv file
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief schema of a csv_parser_t which does not convert columns (the default)
+ */
+struct untyped_t
+{
+    typedef std::tuple<> record_t;      //!< no record
+    static constexpr int columns = 0;   //!< no required column
+};
+
+/**
+ * \brief compile-time list of column types, the first type describing the first column.
+ * Arithmetic types are converted with std::from_chars. std::string_view columns point into the
+ * parsed buffer and are only valid during the callback, std::string columns are copied.
+ * \example csv_parser_t<';','#', schema_t<int64_t, double, std::string_view>>
+ */
+template <class... __columns>
+struct schema_t
+{
+    typedef std::tuple<__columns...> record_t;                  //!< converted row type
+    static constexpr int columns = sizeof...(__columns);        //!< number of typed columns
+};
+
+/**
+ * \brief a column which could not be converted to its schema type
+ */
+struct parse_error_t
+{
+    int         line;       //!< line number in input file
+    int         column;     //!< column index, starting at 0
+    std::errc   code;       //!< std::errc::invalid_argument or std::errc::result_out_of_range
+};
+
+/** \brief convert one field to its schema type, without allocating (except for std::string)
+ * Numbers may be surrounded with blanks, but the remaining characters must all be consumed.
+ * \param [in] field: field content
+ * \param [out] out: converted value
+ * \return std::errc() on success
+ */
+template <class T>
+inline std::errc convert_field(std::string_view field, T& out)
+{
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T,bool>::value
+                  , "schema_t columns must be numbers, std::string_view or std::string");
+    const char* first = field.data();
+    const char* last = first + field.size();
+    while(first < last && (*first == ' ' || *first == '\t'))
+        ++first;
+    while(last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+        --last;
+    std::from_chars_result res = std::from_chars(first, last, out);
+    if(res.ec == std::errc() && res.ptr != last)
+        return std::errc::invalid_argument;
+    return res.ec;
+}
+
+//!< @brief std::string_view columns are not converted
+inline std::errc convert_field(std::string_view field, std::string_view& out)
+{
+    out = field;
+    return std::errc();
+}
+
+//!< @brief std::string columns are copied
+inline std::errc convert_field(std::string_view field, std::string& out)
+{
+    out.assign(field.data(), field.size());
+    return std::errc();
+}
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_CSV_SCHEMA_HEADER
@@ -0,0 +1,463 @@
+#ifndef M_CSV_WRITER_HEADER
+#define M_CSV_WRITER_HEADER
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <memory>
+#include <future>
+#include <charconv>
+#include <algorithm>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <parsers/thread_pool.h>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file csv_writer.h
+ * \brief csv serialization, the counterpart of csv_parser_t
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief growable buffer of csv lines.
+ * Fields are strings (std::string, std::string_view, C strings) or numbers, written with std::to_chars:
+ * floating point numbers get their shortest representation which reads back to the same value, so a file
+ * written from schema_t records is read back by csv_parser_t::each_record unchanged.
+ * With a quote character, fields holding a delimiter, a comment starter, a quote or an end of line are quoted
+ * the way the quoted csv_parser_t reads them, and an empty last field is written as two quotes. Without, fields
+ * are written as they are: they must not hold any of these characters, and an empty last field is not read back.
+ * Clearing keeps the storage: once the buffer has held its largest content, writing does not allocate.
+ */
+template <char __delimiter, char __comment_starter, char __quote = 0>
+struct csv_buffer_t
+{
+    csv_buffer_t(): __data(), __size(0), __capacity(0), __field(0), __first(true) {}
+
+    /**
+    * @brief append a whole line
+    * @param [in] fields: line fields, strings or numbers
+    * return reference to this
+    * @example buffer.row("EUR", 12, 1.5)
+    */
+    template <class... fields_t>
+    csv_buffer_t& row(const fields_t&... fields)
+    {
+        (field(fields), ...);
+        return end_row();
+    }
+
+    /**
+    * @brief append a whole line, from a range of fields
+    * @param [in] first: first field, a string or a number
+    * @param [in] last: one past the last field
+    * return reference to this
+    * @example buffer.row_range(view_row.fields.begin(), view_row.fields.end())
+    */
+    template <class iterator_t>
+    csv_buffer_t& row_range(iterator_t first, iterator_t last)
+    {
+        for(; first != last; ++first)
+            field(*first);
+        return end_row();
+    }
+
+    /**
+    * @brief append a whole line, from a record (a std::tuple, as schema_t records)
+    * @param [in] record: line fields
+    * return reference to this
+    */
+    template <class... fields_t>
+    csv_buffer_t& record(const std::tuple<fields_t...>& record)
+    {
+        std::apply([this](const fields_t&... fields){row(fields...);}, record);
+        return *this;
+    }
+
+    /**
+    * @brief append a comment line
+    * @param [in] text: comment, without its comment starter nor end of line
+    * return reference to this
+    */
+    csv_buffer_t& comment(std::string_view text)
+    {
+        if(!__first)
+            end_row();
+        reserve(text.size() + 2);
+        __data[__size++] = __comment_starter;
+        copy(text);
+        __data[__size++] = '\n';
+        return *this;
+    }
+
+    /**
+    * @brief append one field to the current line, to be ended with end_row()
+    * @param [in] value: a string, a character (written as a one character string) or a number
+    * return reference to this
+    */
+    template <class T>
+    csv_buffer_t& field(const T& value)
+    {
+        reserve(1);
+        if(!__first)
+            __data[__size++] = __delimiter;
+        __first = false;
+        __field = __size;
+        if constexpr (std::is_same<T,char>::value)
+            text(std::string_view(&value, 1));
+        else if constexpr (std::is_arithmetic<T>::value)
+            number(value);
+        else
+            text(std::string_view(value));
+        return *this;
+    }
+
+    //!< @brief end the current line
+    csv_buffer_t& end_row()
+    {
+        reserve(3);
+        if constexpr (__quote != 0)
+        {
+            /* keep the empty last field from being read as no field */
+            if(!__first && __size == __field)
+            {
+                __data[__size++] = __quote;
+                __data[__size++] = __quote;
+            }
+        }
+        __data[__size++] = '\n';
+        __first = true;
+        return *this;
+    }
+
+    //!< @brief serialized lines
+    inline const char* data() const {return __data.get();}
+    //!< @brief number of serialized bytes
+    inline size_t size() const {return __size;}
+    //!< @brief is the buffer empty?
+    inline bool empty() const {return __size == 0;}
+    //!< @brief drop the serialized lines, keeping the storage
+    inline void clear() {__size = 0; __first = true;}
+
+private:
+    std::unique_ptr<char[]>     __data;         //!< serialized lines
+    size_t                      __size;         //!< bytes used in __data
+    size_t                      __capacity;     //!< bytes allocated in __data
+    size_t                      __field;        //!< offset of the last field of the current line
+    bool                        __first;        //!< the next field is the first one of its line
+
+    //!< @brief make room for n more bytes
+    inline void reserve(size_t n)
+    {
+        if(__capacity - __size >= n)
+            return;
+        const size_t capacity = std::max({__capacity * 2, __size + n, (size_t)4096});
+        std::unique_ptr<char[]> data(new char[capacity]);
+        if(__size)
+            memcpy(data.get(), __data.get(), __size);
+        __data = std::move(data);
+        __capacity = capacity;
+    }
+
+    inline void copy(std::string_view text)
+    {
+        memcpy(__data.get() + __size, text.data(), text.size());
+        __size += text.size();
+    }
+
+    template <class T>
+    void number(T value)
+    {
+        static_assert(!std::is_same<T,bool>::value, "csv fields must be numbers or strings");
+        reserve(64);
+        std::to_chars_result res = std::to_chars(__data.get() + __size, __data.get() + __capacity, value);
+        __size = res.ptr - __data.get();
+    }
+
+    void text(std::string_view value)
+    {
+        if constexpr (__quote != 0)
+        {
+            if(needs_quotes(value))
+            {
+                reserve(value.size() * 2 + 2);
+                __data[__size++] = __quote;
+                for(char c : value)
+                {
+                    if(c == __quote)
+                        __data[__size++] = __quote;
+                    __data[__size++] = c;
+                }
+                __data[__size++] = __quote;
+                return;
+            }
+        }
+        reserve(value.size());
+        copy(value);
+    }
+
+    static bool needs_quotes(std::string_view value)
+    {
+        for(char c : value)
+            if(c == __delimiter || c == __comment_starter || c == __quote || c == '\n' || c == '\r')
+                return true;
+        return false;
+    }
+
+    csv_buffer_t(const csv_buffer_t&): __data(), __size(0), __capacity(0), __field(0), __first(true) {GO_UNREACHABLE();}
+    const csv_buffer_t& operator=(const csv_buffer_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+ *  \brief csv file writer, the counterpart of csv_parser_t
+
+## How To Use? ##
+Lines are serialized into a csv_buffer_t, which is written to the file in one call whenever it holds more than
+flush_size bytes:
+
+~~~~~~~~~~{.c}
+    csv_writer_t<';','#'> writer;
+    if(!writer.open("my_output_file.csv"))
+        return;
+    writer.comment(" currency;amount");
+    writer.row("EUR", 12.5);
+    writer.row(std::string_view("USD"), 3);
+    if(!writer.close())
+        cerr<<"write failed";
+~~~~~~~~~~
+
+Many lines can be serialized by several threads with write_parallel: each thread fills its own buffer, and
+the buffers are written in line order:
+
+~~~~~~~~~~{.c}
+    writer.write_parallel(values.size(), [&values](csv_writer_t<';','#'>::buffer_t& buffer, size_t idx)
+    {
+        buffer.row(idx, values[idx]);
+    });
+~~~~~~~~~~
+*/
+template <char __delimiter, char __comment_starter, char __quote = 0>
+struct csv_writer_t
+{
+    typedef csv_buffer_t<__delimiter, __comment_starter, __quote> buffer_t;    //!< serialized lines
+
+    static const size_t default_flush_size = 1 << 20;      //!< 1 MiB
+    static const size_t min_parallel_rows = 4096;          //!< fewest rows serialized by one parallel task
+
+    /**
+    * \param [in] flush_size: the buffer is written once it holds this many bytes
+    */
+    explicit csv_writer_t(size_t flush_size = default_flush_size):
+          __file(nullptr)
+        , __buffer()
+        , __flush_size(std::max(flush_size, (size_t)1))
+        , __failed(false)
+        , __written(0)
+    {}
+
+    ~csv_writer_t() {close();}
+
+    /**
+    * \brief create or truncate a file, closing the previous one
+    * \param [in] filename: file to write
+    * \return true on success
+    */
+    bool open(const std::string& filename)
+    {
+        close();
+        __failed = false;
+        __written = 0;
+        __file = fopen(filename.c_str(), "wb");
+        if(!__file)
+            return false;
+        setvbuf(__file, nullptr, _IONBF, 0);
+        return true;
+    }
+
+    /**
+    * \brief write the buffered lines, and close the file
+    * \return false if a write failed since open()
+    */
+    bool close()
+    {
+        if(!__file)
+            return !__failed;
+        flush();
+        if(fclose(__file))
+            __failed = true;
+        __file = nullptr;
+        return !__failed;
+    }
+
+    /**
+    * \brief write the buffered lines now
+    * \return false if a write failed since open()
+    */
+    bool flush()
+    {
+        write_out(__buffer);
+        __buffer.clear();
+        return !__failed;
+    }
+
+    //!< @brief did every write succeed since open()?
+    inline bool good() const {return __file && !__failed;}
+    //!< @brief number of bytes written to the file so far
+    inline uint64_t bytes_written() const {return __written;}
+
+    /**
+    * \brief write a line
+    * \param [in] fields: line fields, strings or numbers
+    */
+    template <class... fields_t>
+    void row(const fields_t&... fields)
+    {
+        __buffer.row(fields...);
+        flush_if_full();
+    }
+
+    /**
+    * \brief write a line, from a range of fields
+    * \param [in] first: first field, a string or a number
+    * \param [in] last: one past the last field
+    */
+    template <class iterator_t>
+    void row_range(iterator_t first, iterator_t last)
+    {
+        __buffer.row_range(first, last);
+        flush_if_full();
+    }
+
+    /**
+    * \brief write a line, from a record (a std::tuple, as schema_t records)
+    * \param [in] record: line fields
+    */
+    template <class... fields_t>
+    void record(const std::tuple<fields_t...>& record)
+    {
+        __buffer.record(record);
+        flush_if_full();
+    }
+
+    /**
+    * \brief write a comment line
+    * \param [in] text: comment, without its comment starter nor end of line
+    */
+    void comment(std::string_view text)
+    {
+        __buffer.comment(text);
+        flush_if_full();
+    }
+
+    /**
+    * \brief serialize rows with several threads, and write them in order
+    * rows are cut into ranges, serialized by a pool of threads into their own buffers. The calling thread
+    * writes the buffers in row order, while at most 2 ranges per thread are serialized ahead. Buffers are
+    * reused from range to range. fn is called concurrently from several threads, and has to be thread safe.
+    * \param [in] rows: number of rows
+    * \param [in] fn: fn(buffer_t& buffer, size_t idx) appends row idx (0 to rows - 1) to buffer. It may append
+    * any number of lines, or none.
+    * \param [in] threads: number of serializing threads, 0 means one per hardware thread
+    * \return false if a write failed since open()
+    */
+    template <class fn_t>
+    bool write_parallel(size_t rows, fn_t&& fn, int threads = 0)
+    {
+        flush();
+        thread_pool_t pool(threads);
+        const size_t step = std::max(rows / ((size_t)pool.size() * 4), min_parallel_rows);
+        const size_t ranges = (rows + step - 1) / step;
+        const size_t window = std::min((size_t)pool.size() * 2, std::max(ranges, (size_t)1));
+        std::vector<buffer_t> shards(window);
+        std::deque<std::future<void>> pending;
+        size_t submitted = 0;
+        try
+        {
+            for(size_t r=0; r < ranges; ++r)
+            {
+                for(; submitted < ranges && submitted < r + window; ++submitted)
+                {
+                    buffer_t* shard = &shards[submitted % window];
+                    const size_t first = submitted * step;
+                    const size_t last = std::min(first + step, rows);
+                    pending.push_back(pool.submit([shard, first, last, &fn]
+                    {
+                        shard->clear();
+                        for(size_t idx=first; idx < last; ++idx)
+                            fn(*shard, idx);
+                    }));
+                }
+                pending.front().get();
+                pending.pop_front();
+                write_out(shards[r % window]);
+            }
+        }
+        catch(...)
+        {
+            pool.wait();
+            throw;
+        }
+        return !__failed;
+    }
+
+private:
+    FILE*       __file;         //!< written file
+    buffer_t    __buffer;       //!< lines not written yet
+    size_t      __flush_size;   //!< __buffer is written once it holds this many bytes
+    bool        __failed;       //!< a write failed since open()
+    uint64_t    __written;      //!< bytes written since open()
+
+    inline void flush_if_full()
+    {
+        if(__buffer.size() >= __flush_size)
+            flush();
+    }
+
+    void write_out(const buffer_t& buffer)
+    {
+        if(buffer.empty())
+            return;
+        if(!__file || fwrite(buffer.data(), 1, buffer.size(), __file) != buffer.size())
+        {
+            __failed = true;
+            return;
+        }
+        __written += buffer.size();
+    }
+
+    csv_writer_t(const csv_writer_t&):
+          __file(nullptr)
+        , __buffer()
+        , __flush_size(0)
+        , __failed(true)
+        , __written(0)
+    {GO_UNREACHABLE();}
+    const csv_writer_t& operator=(const csv_writer_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+typedef csv_writer_t<';','#'> generic_csv_writer_t;             //!< writer of generic_csv_parser_t files
+typedef csv_writer_t<';','#','"'> quoted_csv_writer_t;          //!< writer of quoted_csv_parser_t files
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_CSV_WRITER_HEADER
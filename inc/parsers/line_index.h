@@ -0,0 +1,113 @@
+#ifndef M_LINE_INDEX_HEADER
+#define M_LINE_INDEX_HEADER
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file line_index.h
+ * \brief sparse line to byte offset index of a text file, kept in a sidecar file
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief byte offset of every stride-th line of a file.
+ * Line numbers start at 1, like the parsers ones: entry k holds the offset of line k * stride + 1.
+ * The index remembers the size and modification time of the file it was built from, and is only used while
+ * both still match. It is saved next to the file, as filename + ".idx" (host byte order).
+ */
+struct line_index_t
+{
+    static const int default_stride = 1024;     //!< lines between two entries
+
+    /**
+    * \param [in] stride: lines between two entries, at least 1
+    */
+    explicit line_index_t(int stride = default_stride);
+
+    /**
+    * \brief drop every entry, and start a new index
+    * \param [in] stride: lines between two entries, at least 1
+    */
+    void reset(int stride);
+
+    //!< @brief record that line starts at offset. Lines have to be given in order, from the first one
+    inline void add(int line, uint64_t offset)
+    {
+        if((line - 1) % __stride == 0 && (size_t)((line - 1) / __stride) == __offsets.size())
+            __offsets.push_back(offset);
+    }
+
+    /**
+    * \brief mark the index complete, and stamp it with the size and modification time of the indexed file
+    * \param [in] filename: indexed file
+    * \param [in] lines: number of lines of the file
+    * \return false if the file can not be stat'ed
+    */
+    bool complete(const std::string& filename, int lines);
+
+    /**
+    * \brief does the index describe the current content of a file?
+    * \param [in] filename: indexed file
+    * \return true if the index is complete, and the file size and modification time did not change
+    */
+    bool valid_for(const std::string& filename) const;
+
+    /**
+    * \brief nearest indexed line at or before a line
+    * \param [in] line: wanted line, from 1
+    * \param [out] indexed_line: nearest indexed line
+    * \param [out] offset: byte offset of indexed_line
+    * \return false if the index is empty
+    */
+    bool locate(int line, int& indexed_line, uint64_t& offset) const;
+
+    /**
+    * \brief write the index to a file
+    * \param [in] filename: index file
+    * \return true on success
+    */
+    bool save(const std::string& filename) const;
+
+    /**
+    * \brief read an index written by save()
+    * \param [in] filename: index file
+    * \return true on success; on failure the index is left empty
+    */
+    bool load(const std::string& filename);
+
+    //!< @brief sidecar index file name of a file
+    static inline std::string sidecar(const std::string& filename) {return filename + ".idx";}
+
+    //!< @brief lines between two entries
+    inline int stride() const {return __stride;}
+    //!< @brief number of lines of the indexed file, once complete
+    inline int lines() const {return __lines;}
+    //!< @brief indexed offsets, entry k being the one of line k * stride() + 1
+    inline const std::vector<uint64_t>& offsets() const {return __offsets;}
+
+private:
+    int                     __stride;       //!< lines between two entries
+    int                     __lines;        //!< number of lines, -1 while incomplete
+    uint64_t                __file_size;    //!< indexed file size
+    int64_t                 __file_mtime;   //!< indexed file modification time
+    std::vector<uint64_t>   __offsets;      //!< offset of every stride-th line
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_LINE_INDEX_HEADER
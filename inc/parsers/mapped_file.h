@@ -0,0 +1,80 @@
+#ifndef M_MAPPED_FILE_HEADER
+#define M_MAPPED_FILE_HEADER
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file mapped_file.h
+ * \brief read only memory mapping of a whole file
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief read only view over a whole file content.
+ * On POSIX systems the file is mapped with mmap(), so no byte is copied until it is touched.
+ * Elsewhere the content is read once into a private buffer. In both cases, data() stays valid
+ * until close() is called or the object is destroyed.
+ */
+struct mapped_file_t
+{
+    mapped_file_t();
+    ~mapped_file_t();
+
+    /**
+    * \brief map a file
+    * \param [in] filename: file to map
+    * \return true on success. An empty file is a success with size() == 0
+    */
+    bool open(const std::string& filename);
+
+    /**
+    * \brief unmap the current file, if any
+    */
+    void close();
+
+    //!< @brief first byte of the file content
+    inline const char* data() const {return __data;}
+    //!< @brief file content size in bytes
+    inline size_t size() const {return __size;}
+    //!< @brief one past the last byte of the file content
+    inline const char* end() const {return __data + __size;}
+    //!< @brief is a file currently mapped?
+    inline bool is_open() const {return __opened;}
+
+private:
+    const char*         __data;         //!< mapped content
+    size_t              __size;         //!< content size
+    bool                __opened;       //!< open() succeeded
+    std::vector<char>   __fallback;     //!< content holder when mmap is not available
+
+    mapped_file_t(const mapped_file_t&) :
+          __data(nullptr)
+        , __size(0)
+        , __opened(false)
+        , __fallback()
+    {GO_UNREACHABLE();}
+    const mapped_file_t& operator=(const mapped_file_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_MAPPED_FILE_HEADER
@@ -1,61 +1,190 @@
-#ifndef M_STRING_UTILS_HEADER
-#define M_STRING_UTILS_HEADER
-
-/*c++ std includes*/
-#include <vector>
-#include <iostream>
-
-namespace mparsers
-{
-    /** \defgroup mtools_string String utils
-     * \brief A set function of useful string related operations
-     * \{
-     * \file mstring_utils.h
-     * \brief some useful stuffs to handle strings
-     * \author Marouane BELAOUCHA
-     */
-
-
-    /** \brief split a string
-     * \param [in] str: string to split
-     * \param [int] delimiter: delimiter  character
-     * \return a vector of split parts
-     */
-    std::vector<std::string> split(const std::string &str, char delimiter);
-
-    /** \brief ingore a comment part in a string
-     * \param [in] str: string process
-     * \param [int] comment_char: comment starter character
-     * \return uncommented string
-     */
-    std::string ignore_comment(const std::string& str, char comment_char);
-
-    /** \brief trim a C string
-     * \param [in,out] s: string to trim
-     * \return trimmed string
-     */
-    char* strtrim(char* s);
-
-    /** \brief trim a string
-     * \param [in] str: string to trim
-     * \return trimmed string
-     */
-    std::string stdstrim(const std::string& str);
-
-    /** \brief build a safe file name from any given random string
-     * the process consists on replacing every unsafe character by '_'. Safe characters are alpha-numeral and/or '_'.
-     * \param [in] str: input string
-     * \return safe base which can be used as a file name
-     */
-    std::string build_filename(const std::string& str);
-
-
-    std::string splitpath(const std::string& filename);
-    std::string splitext(const std::string& filename);
-
-} /* namespace mparsers */
-
-/**
-* \}
-*/
-#endif /*MERLIN_STRING_UTILS_HEADER*/
+#ifndef M_STRING_UTILS_HEADER
+#define M_STRING_UTILS_HEADER
+
+/*c++ std includes*/
+#include <vector>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <cstddef>
+#include <cstring>
+
+namespace mparsers
+{
+    /** \defgroup mtools_string String utils
+     * \brief A set function of useful string related operations
+     * \{
+     * \file mstring_utils.h
+     * \brief some useful stuffs to handle strings
+     * \author Marouane BELAOUCHA
+     */
+
+
+    /** \brief split a string
+     * \param [in] str: string to split
+     * \param [int] delimiter: delimiter  character
+     * \return a vector of split parts
+     */
+    std::vector<std::string> split(const std::string &str, char delimiter);
+
+    /** \brief ingore a comment part in a string
+     * \param [in] str: string process
+     * \param [int] comment_char: comment starter character
+     * \return uncommented string
+     */
+    std::string ignore_comment(const std::string& str, char comment_char);
+
+    /** \brief trim a C string
+     * \param [in,out] s: string to trim
+     * \return trimmed string
+     */
+    char* strtrim(char* s);
+
+    /** \brief trim a string
+     * \param [in] str: string to trim
+     * \return trimmed string
+     */
+    std::string stdstrim(const std::string& str);
+
+    /** \brief build a safe file name from any given random string
+     * the process consists on replacing every unsafe character by '_'. Safe characters are alpha-numeral and/or '_'.
+     * \param [in] str: input string
+     * \return safe base which can be used as a file name
+     */
+    std::string build_filename(const std::string& str);
+
+
+    std::string splitpath(const std::string& filename);
+    std::string splitext(const std::string& filename);
+
+    /** \name Allocation-free versions
+     * These functions return views into their input, and never allocate. Blanks are ' ', '\\t', '\\r' and '\\n'.
+     * \{
+     */
+
+    /** \brief trim a string, SSE2/AVX2 on long blank runs
+     * \param [in] str: string to trim
+     * \return trimmed part of str. For a blank string, an empty view at the end of str
+     */
+    std::string_view trim_view(std::string_view str);
+
+    /** \brief ignore a comment part in a string
+     * \param [in] str: string process
+     * \param [in] comment_char: comment starter character
+     * \return part of str before the comment starter, str if none
+     */
+    inline std::string_view ignore_comment_view(std::string_view str, char comment_char)
+    {
+        return str.substr(0, str.find(comment_char));
+    }
+
+    /** \brief split a string into caller storage, the same way split does:
+     * an empty string has no part, and an empty last part is dropped.
+     * \param [in] str: string to split
+     * \param [in] delimiter: delimiter character
+     * \param [out] parts: receives the first max_parts parts
+     * \param [in] max_parts: room in parts
+     * \return number of parts of str, which may be more than max_parts
+     */
+    size_t split_view(std::string_view str, char delimiter, std::string_view* parts, size_t max_parts);
+
+    /** \brief forward iterator over the parts of a string, see split_view(str, delimiter)
+     */
+    struct split_iterator_t
+    {
+        typedef std::forward_iterator_tag   iterator_category;  //!< iterator traits
+        typedef std::string_view            value_type;         //!< iterator traits
+        typedef std::ptrdiff_t              difference_type;    //!< iterator traits
+        typedef const std::string_view*     pointer;            //!< iterator traits
+        typedef const std::string_view&     reference;          //!< iterator traits
+
+        //!< @brief end iterator
+        split_iterator_t(): __part(), __next(nullptr), __last(nullptr), __delimiter(0) {}
+        /**
+        * \param [in] str: string to split
+        * \param [in] delimiter: delimiter character
+        */
+        split_iterator_t(std::string_view str, char delimiter):
+              __part()
+            , __next(str.data())
+            , __last(str.data() + str.size())
+            , __delimiter(delimiter)
+        {
+            ++*this;
+        }
+
+        inline reference operator*() const {return __part;}
+        inline pointer operator->() const {return &__part;}
+        inline bool operator==(const split_iterator_t& o) const {return __next == o.__next && __part.data() == o.__part.data();}
+        inline bool operator!=(const split_iterator_t& o) const {return !(*this == o);}
+        inline split_iterator_t operator++(int) {split_iterator_t it = *this; ++*this; return it;}
+        split_iterator_t& operator++()
+        {
+            if(__next == __last)
+            {
+                *this = split_iterator_t();
+                return *this;
+            }
+            const char* end = static_cast<const char*>(memchr(__next, __delimiter, __last - __next));
+            if(!end)
+                end = __last;
+            __part = std::string_view(__next, end - __next);
+            __next = end < __last ? end + 1 : end;
+            return *this;
+        }
+
+    private:
+        std::string_view    __part;         //!< current part
+        const char*         __next;         //!< beginning of the next part, null at the end
+        const char*         __last;         //!< end of the split string
+        char                __delimiter;    //!< delimiter character
+    };
+
+    /** \brief parts of a string, split lazily while iterating
+     */
+    struct split_range_t
+    {
+        split_iterator_t first;     //!< first part
+        inline split_iterator_t begin() const {return first;}
+        inline split_iterator_t end() const {return split_iterator_t();}
+    };
+
+    /** \brief split a string lazily, the same way split does
+     * \param [in] str: string to split, which has to outlive the range
+     * \param [in] delimiter: delimiter character
+     * \return range of parts
+     * \example for(std::string_view part : split_view(line, ';')) {...}
+     */
+    inline split_range_t split_view(std::string_view str, char delimiter)
+    {
+        return split_range_t{split_iterator_t(str, delimiter)};
+    }
+
+    /** \brief directory part of a path, the same way splitpath does
+     * \param [in] filename: path, '/' or '\\' separated
+     * \return part of filename before its last separator, empty if none, filename if it ends with one
+     */
+    std::string_view splitpath_view(std::string_view filename);
+
+    /** \brief extension of a file name, the same way splitext does
+     * \param [in] filename: file name
+     * \return part of filename after its last '.' (a trailing '.' is ignored), filename if it has none
+     */
+    std::string_view splitext_view(std::string_view filename);
+
+    /** \brief build a safe file name from any given random string, into caller storage, SSE2/AVX2 accelerated.
+     * Every character which is not an ASCII letter or digit is replaced by '_'.
+     * \param [in] str: input string
+     * \param [out] out: receives str.size() characters, not null terminated. It may be str.data()
+     */
+    void build_filename(std::string_view str, char* out);
+
+    /** \} */
+
+} /* namespace mparsers */
+
+/**
+* \}
+*/
+#endif /*MERLIN_STRING_UTILS_HEADER*/
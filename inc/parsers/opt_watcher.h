@@ -0,0 +1,172 @@
+#ifndef M_OPT_WATCHER_HEADER
+#define M_OPT_WATCHER_HEADER
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <cassert>
+#include <parsers/var_assign_parser.h>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file opt_watcher.h
+ * \brief hot reload of assignment files, notifying changed commands only
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief keeps assignment files in sync with their content, and only notifies what changed.
+ * For each watched file, the watcher keeps the last value of every command (the last assignment wins).
+ * When the file changes, only the lines touched by the modified byte range are tokenized again, then:
+ *    - the callback registered in the opt_parser_t (or its unexpected command handler) is called for each
+ *      command which was added or whose value changed, with its new value;
+ *    - the changed handler, if any, is called for each command whose value changed;
+ *    - the removed handler, if any, is called for each command which disappeared.
+ *
+ * On Linux, files are watched with inotify (on their directory, so that editors replacing the file are seen).
+ * Elsewhere, poll() compares modification times.
+
+~~~~~~~~~~
+opt_parser_t parser;
+parser.add_cmd_parser("COMMAND_ONE", nullptr, on_command_one);
+opt_watcher_t watcher(parser);
+watcher.set_removed_handler([](const std::string& cmd, const char* old_value){...});
+watcher.watch("my_config_file.cfg");     // every command is notified once, as added
+for(;;)
+    watcher.poll(1000);                  // notifies changes only
+~~~~~~~~~~
+ */
+struct opt_watcher_t
+{
+    typedef std::function<void(const std::string& cmd, const char* old_value, const char* new_value, int line)>
+        changed_handler_t;      //!< values are null when the command has no value
+    typedef std::function<void(const std::string& cmd, const char* old_value)>
+        removed_handler_t;      //!< old_value is null when the command had no value
+
+    /**
+    * \param [in,out] parser: holds the commands callbacks, must outlive the watcher
+    */
+    explicit opt_watcher_t(opt_parser_t& parser);
+    ~opt_watcher_t();
+
+    /**
+    * \brief start watching a file: it is parsed, and every command is notified as added
+    * \param [in] filename: assignment file
+    * \return false if the file can not be read
+    */
+    bool watch(const std::string& filename);
+
+    /**
+    * \brief stop watching a file, and forget its state (nothing is notified)
+    * \param [in] filename: assignment file
+    */
+    void unwatch(const std::string& filename);
+
+    /**
+    * \brief wait for changes of the watched files, then reload the changed ones
+    * \param [in] timeout_ms: maximum wait in milliseconds, 0 returns immediately, negative waits forever
+    * \return number of reloaded files
+    */
+    int poll(int timeout_ms);
+
+    /**
+    * \brief read a watched file again, and notify what changed since the last time
+    * \param [in] filename: assignment file
+    * \return false if the file is not watched or can not be read
+    */
+    bool reload(const std::string& filename);
+
+    //!< @brief set the handler of commands whose value changed
+    inline void set_changed_handler(const changed_handler_t& handler) {changed = handler;}
+    //!< @brief set the handler of commands which disappeared
+    inline void set_removed_handler(const removed_handler_t& handler) {removed = handler;}
+    //!< @brief inotify descriptor to wait on in a user event loop (-1 when not available)
+    inline int fd() const {return notify_fd;}
+
+private:
+    /**
+    * \brief one line of a watched file
+    */
+    struct line_t
+    {
+        size_t          offset;     //!< first byte of the line
+        size_t          length;     //!< line length, end of line included
+        bool            assigns;    //!< the line holds a command
+        bool            has_value;  //!< the command has a value
+        std::string     command;    //!< command name
+        std::string     value;      //!< command value
+    };
+
+    /**
+    * \brief last known value of a command
+    */
+    struct value_t
+    {
+        bool            has_value;  //!< the command has a value
+        std::string     value;      //!< command value
+        int             line;       //!< line of the last assignment
+
+        value_t(): has_value(false), value(), line(0) {}
+    };
+
+    /**
+    * \brief state of a watched file
+    */
+    struct file_state_t
+    {
+        std::string                                 content;    //!< last read content
+        std::vector<line_t>                         lines;      //!< tokenized lines
+        std::unordered_map<std::string, value_t>    values;     //!< command -> last value
+        long long                                   mtime;      //!< last modification time (polling fallback)
+
+        file_state_t(): content(), lines(), values(), mtime(0) {}
+    };
+
+    /**
+    * \brief tokenize the lines of content[first, last), appending them to lines
+    */
+    static void tokenize_lines(const std::string& content, size_t first, size_t last, std::vector<line_t>& lines);
+
+    /**
+    * \brief update a file state with its new content, and notify what changed
+    */
+    void apply(file_state_t& state, std::string&& content);
+
+    opt_parser_t&                                   parser;         //!< commands callbacks
+    std::map<std::string, file_state_t>             files;          //!< watched files
+    std::map<int, std::string>                      directories;    //!< inotify watch -> watched directory
+    changed_handler_t                               changed;        //!< changed values handler
+    removed_handler_t                               removed;        //!< removed commands handler
+    int                                             notify_fd;      //!< inotify descriptor
+
+    opt_watcher_t(const opt_watcher_t& o):
+          parser(o.parser)
+        , files()
+        , directories()
+        , changed()
+        , removed()
+        , notify_fd(-1)
+    {GO_UNREACHABLE();}
+    const opt_watcher_t& operator=(const opt_watcher_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_OPT_WATCHER_HEADER
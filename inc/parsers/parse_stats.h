@@ -0,0 +1,149 @@
+#ifndef M_PARSE_STATS_HEADER
+#define M_PARSE_STATS_HEADER
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <parsers/block_reader.h>
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file parse_stats.h
+ * \brief opt-in parsing statistics, compiled out by default
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief what a parse did, and where its time went.
+ * Times are cumulative nanoseconds. With several threads, they add up the time of every thread.
+ */
+struct parse_stats_t
+{
+    uint64_t    bytes_read;         //!< bytes read from the input (decompressed bytes for compressed files)
+    uint64_t    lines;              //!< lines read
+    uint64_t    rows;               //!< rows (or commands) given to the user callbacks
+    uint64_t    rejected_rows;      //!< lines holding fields (or a command) which were not delivered
+    uint64_t    comment_lines;      //!< lines holding a comment only
+    uint64_t    empty_lines;        //!< lines holding nothing
+    uint64_t    unknown_commands;   //!< commands given to the unknown command handler
+    uint64_t    io_ns;              //!< time spent reading the input
+    uint64_t    scan_ns;            //!< time spent locating lines and fields
+    uint64_t    materialize_ns;     //!< time spent copying or converting fields
+    uint64_t    callback_ns;        //!< time spent in user callbacks
+
+    parse_stats_t():
+          bytes_read(0)
+        , lines(0)
+        , rows(0)
+        , rejected_rows(0)
+        , comment_lines(0)
+        , empty_lines(0)
+        , unknown_commands(0)
+        , io_ns(0)
+        , scan_ns(0)
+        , materialize_ns(0)
+        , callback_ns(0)
+    {}
+
+    //!< @brief add the counters of another parse
+    parse_stats_t& operator+=(const parse_stats_t& o);
+
+    /**
+    * \brief export the counters as a JSON object, one member per counter
+    * \return JSON text
+    */
+    std::string to_json() const;
+};
+
+/**
+ * \brief statistics policy which collects nothing: every call compiles to nothing. This is the default policy.
+ */
+struct no_stats_t
+{
+    static constexpr bool enabled = false;      //!< statistics are not collected
+
+    inline void count(uint64_t parse_stats_t::*, uint64_t = 1) {}
+    inline uint64_t clock() const {return 0;}
+    inline void time(uint64_t parse_stats_t::*, uint64_t) {}
+    inline void merge(const no_stats_t&) {}
+    inline void reset() {}
+    inline parse_stats_t snapshot() const {return parse_stats_t();}
+};
+
+/**
+ * \brief statistics policy which collects counters and timings.
+ * Timing reads a steady clock a few times per line: expect parsing to be noticeably slower than without
+ * statistics.
+ */
+struct collect_stats_t
+{
+    static constexpr bool enabled = true;       //!< statistics are collected
+
+    parse_stats_t stats;                        //!< collected statistics
+
+    collect_stats_t(): stats() {}
+
+    //!< @brief add n to a counter
+    inline void count(uint64_t parse_stats_t::* counter, uint64_t n = 1) {stats.*counter += n;}
+    //!< @brief current time in nanoseconds, to give to time()
+    inline uint64_t clock() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    //!< @brief add the time elapsed since a clock() value to a timer
+    inline void time(uint64_t parse_stats_t::* timer, uint64_t since) {stats.*timer += clock() - since;}
+    //!< @brief add the statistics of another collector (of another thread)
+    inline void merge(const collect_stats_t& o) {stats += o.stats;}
+    //!< @brief zero every counter
+    inline void reset() {stats = parse_stats_t();}
+    //!< @brief collected statistics
+    inline parse_stats_t snapshot() const {return stats;}
+};
+
+/**
+ * \brief input source counting the bytes and the time of the reads of another source
+ */
+template <class __stats>
+struct timed_source_t : public input_source_t
+{
+    /**
+    * \param [in,out] src: timed source, must outlive this one
+    * \param [in,out] st: statistics receiving bytes_read and io_ns
+    */
+    timed_source_t(input_source_t& src, __stats& st): source(src), stats(st), elapsed_ns(0) {}
+
+    size_t read(char* buffer, size_t size) override
+    {
+        const uint64_t since = stats.clock();
+        const size_t n = source.read(buffer, size);
+        const uint64_t spent = stats.clock() - since;
+        stats.count(&parse_stats_t::io_ns, spent);
+        stats.count(&parse_stats_t::bytes_read, n);
+        elapsed_ns += spent;
+        return n;
+    }
+
+    //!< @brief time spent in reads so far, to exclude it from enclosing timings
+    inline uint64_t elapsed() const {return elapsed_ns;}
+
+private:
+    input_source_t& source;     //!< timed source
+    __stats&        stats;      //!< receives the counters
+    uint64_t        elapsed_ns; //!< time spent in reads so far
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_PARSE_STATS_HEADER
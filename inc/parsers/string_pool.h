@@ -0,0 +1,128 @@
+#ifndef M_STRING_POOL_HEADER
+#define M_STRING_POOL_HEADER
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file string_pool.h
+ * \brief string interning, for low cardinality columns
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief set of distinct strings, each one stored once and numbered in insertion order.
+ * Ids are dense, from 0 to size() - 1, and can index plain arrays. Stored strings never move: their
+ * std::string_view stay valid until clear() or the pool destruction.
+ */
+struct string_pool_t
+{
+    static const uint32_t npos = UINT32_MAX;            //!< id of no string
+    static const size_t block_size = 64 << 10;          //!< bytes allocated at once for the strings
+
+    string_pool_t();
+
+    /**
+    * \brief id of a string, stored first if the pool does not hold it yet
+    * \param [in] value: string to intern
+    * \return string id
+    */
+    uint32_t intern(std::string_view value);
+
+    /**
+    * \brief id of a string, without storing it
+    * \param [in] value: string to look for
+    * \return string id, npos if the pool does not hold it
+    */
+    uint32_t find(std::string_view value) const;
+
+    //!< @brief stored string of an id
+    inline std::string_view value(uint32_t id) const {return __values[id];}
+    //!< @brief number of distinct strings
+    inline size_t size() const {return __values.size();}
+    //!< @brief stored strings, indexed by id
+    inline const std::vector<std::string_view>& values() const {return __values;}
+
+    //!< @brief drop every string. Ids restart from 0
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<char[]>>            __blocks;   //!< strings storage
+    size_t                                          __used;     //!< bytes used in the last block
+    size_t                                          __capacity; //!< size of the last block
+    std::vector<uint32_t>                           __slots;    //!< open addressing table of id + 1, 0 when free
+    std::vector<size_t>                             __hashes;   //!< id -> hash of its string
+    std::vector<std::string_view>                   __values;   //!< id -> stored string
+
+    //!< @brief slot holding a string, or the free slot where it belongs
+    inline size_t slot(std::string_view value, size_t hash) const
+    {
+        const size_t mask = __slots.size() - 1;
+        size_t it = hash & mask;
+        while(__slots[it] && (__hashes[__slots[it] - 1] != hash || __values[__slots[it] - 1] != value))
+            it = (it + 1) & mask;
+        return it;
+    }
+
+    //!< @brief double the table size, keeping it at most half full
+    void grow();
+
+    string_pool_t(const string_pool_t&): __blocks(), __used(0), __capacity(0), __slots(), __hashes(), __values()
+    {GO_UNREACHABLE();}
+    const string_pool_t& operator=(const string_pool_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+ * \brief one string pool per interned column of a file
+ */
+struct column_dictionaries_t
+{
+    column_dictionaries_t(): __pools(), __none() {}
+
+    /**
+    * \brief choose the interned columns, dropping every stored string
+    * \param [in] columns: interned column indices, empty to intern none
+    */
+    void reset(const std::vector<int>& columns);
+
+    //!< @brief is a column interned?
+    inline bool has(size_t column) const {return column < __pools.size() && __pools[column];}
+    //!< @brief is any column interned?
+    inline bool empty() const {return __pools.empty();}
+    //!< @brief pool of an interned column
+    inline string_pool_t& pool(size_t column) {return *__pools[column];}
+    //!< @brief pool of a column, an empty pool if the column is not interned
+    inline const string_pool_t& pool(size_t column) const {return has(column) ? *__pools[column] : __none;}
+
+private:
+    std::vector<std::unique_ptr<string_pool_t>>     __pools;    //!< pool of each column, null if not interned
+    string_pool_t                                   __none;     //!< pool of the columns not interned, always empty
+
+    column_dictionaries_t(const column_dictionaries_t&): __pools(), __none() {GO_UNREACHABLE();}
+    const column_dictionaries_t& operator=(const column_dictionaries_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_STRING_POOL_HEADER
@@ -0,0 +1,119 @@
+#ifndef M_THREAD_POOL_HEADER
+#define M_THREAD_POOL_HEADER
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <cassert>
+
+#ifndef GO_UNREACHABLE
+#define GO_UNREACHABLE() assert(0)
+#endif
+
+namespace mparsers
+{
+
+/**
+ * \addtogroup parsers_group Parsers
+ * @{
+ */
+
+/**
+ * \file thread_pool.h
+ * \brief fixed size pool of worker threads used by the parallel parsers
+ * \author Marouane BELAOUCHA
+ */
+
+/**
+ * \brief fixed size pool of work stealing threads.
+ * Each worker owns a task queue. Tasks submitted from outside the pool are spread over the queues
+ * round robin, tasks submitted by a task go to the queue of its worker. A worker runs its own tasks
+ * oldest first, and steals the oldest task of another queue when its own queue is empty.
+ * Each submitted task gets a std::future, which also carries any exception thrown by the task.
+ */
+struct thread_pool_t
+{
+    /**
+    * \brief start the workers
+    * \param [in] threads: number of workers, 0 means one per hardware thread
+    */
+    explicit thread_pool_t(int threads = 0);
+
+    /**
+    * \brief run remaining tasks, then join the workers
+    */
+    ~thread_pool_t();
+
+    /**
+    * \brief queue a task
+    * \param [in] task: function to run on a worker
+    * \return future becoming ready when the task is over
+    */
+    std::future<void> submit(std::function<void()> task);
+
+    /**
+    * \brief block until every submitted task is over
+    */
+    void wait();
+
+    //!< @brief number of workers
+    inline int size() const {return (int)workers.size();}
+
+private:
+    /**
+    * \brief tasks owned by one worker
+    */
+    struct queue_t
+    {
+        std::mutex                              lock;       //!< protects tasks
+        std::deque<std::packaged_task<void()>>  tasks;      //!< pending tasks
+        queue_t(): lock(), tasks() {}
+    };
+
+    void worker_loop(int self);
+
+    /**
+    * \brief take the oldest task of queue self, or steal one from another queue
+    * \param [in] self: queue to look at first
+    * \param [out] task: taken task
+    * \return false if every queue is empty
+    */
+    bool pop_task(int self, std::packaged_task<void()>& task);
+
+    std::vector<std::thread>                    workers;    //!< worker threads
+    std::vector<std::unique_ptr<queue_t>>       queues;     //!< one task queue per worker
+    std::mutex                                  lock;       //!< sleeping workers and waiters
+    std::condition_variable                     wakeup;     //!< signaled when a task is queued
+    std::condition_variable                     idle;       //!< signaled when a task is over
+    std::atomic<size_t>                         queued;     //!< tasks waiting in the queues
+    std::atomic<int>                            running;    //!< tasks currently being run
+    std::atomic<size_t>                         next_queue; //!< round robin queue of outside submissions
+    bool                                        stopping;   //!< the destructor was called
+
+    thread_pool_t(const thread_pool_t&) :
+          workers()
+        , queues()
+        , lock()
+        , wakeup()
+        , idle()
+        , queued(0)
+        , running(0)
+        , next_queue(0)
+        , stopping(false)
+    {GO_UNREACHABLE();}
+    const thread_pool_t& operator=(const thread_pool_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+/**
+* @} // addtogroup
+*/
+
+} /* namespace mparsers */
+
+#endif // M_THREAD_POOL_HEADER
@@ -1,217 +1,593 @@
-#ifndef VAR_ASSIGN_PARSER_T_HEADER_INC
-#define VAR_ASSIGN_PARSER_T_HEADER_INC
-
-#include <iostream>
-#include <functional>
+#ifndef VAR_ASSIGN_PARSER_T_HEADER_INC
+#define VAR_ASSIGN_PARSER_T_HEADER_INC
+
+#include <iostream>
+#include <functional>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <exception>
+#include <type_traits>
+#include <parsers/mstring_utils.h>
+#include <parsers/csv_schema.h>
+#include <parsers/command_table.h>
+#include <parsers/thread_pool.h>
+#include <parsers/parse_stats.h>
 
-#include <cassert>
+#include <cassert>
 
 
 #ifndef GO_UNREACHABLE
 #define GO_UNREACHABLE() assert(0)
-#endif
-
-namespace mparsers
-{
-
-/**
- * \defgroup parsers_group Parsers
- * \brief some useful parsers
- * @{
- * \file var_assign_parser.h
- * \brief parser for variable assignment sequence file.
- * \author Marouane BELAOUCHA
- */
-
-
-/**
- *  \brief option file parser
-
-## How To Use? ##
- The file to parse is a sequence of variable assignment commands of this form:
-~~~~~~~~~~
-1:    # this is a comment
-2:    COMMAND_ONE = this is value  ; this will be ignored
-3:    COMMAND_two = ETH 1 0 20 15    # this will be ignored
-4:    cOmMaNd_tHrEe = dummy
-    ...
-~~~~~~~~~~
-Here characters ';' and '#' are used as comment starters, with effect till the end of line.
-The #opt_parser_t parser iterates over file's lines looking for assignments. The assignment
-left hand side denotes the command name (case sensitive) which should be registered using
-opt_parser_t#add_cmd_parser, before paring with  opt_parser_t#parse.
-
-The input seen by parser for the example above is:
-~~~~~~~~~~
-1:
-2:    COMMAND_ONE = this is value
-3:    COMMAND_two = ETH 1 0 20 15
-4:    cOmMaNd_tHrEe = dummy
-    ...
-~~~~~~~~~~
-
-A parser for such file could be initialized this way:
-
-~~~~~~~~~~
-opt_parser_t parser;
-...
-parser.add_cmd_parser("COMMAND_ONE", nullptr, [](const std::string& cmd, char* value, void* userdata, int line)
-                      {
-                        assert(cmd == "COMMAND_ONE");
-                        assert(userdata == nullptr);
-                        cout <<std::endl<< "line#"<<line<<": the command  '"<<cmd<<"' got the value '"<<value<<"'";
-                      });
-
-parser.add_cmd_parser("COMMAND_two", nullptr, [](const std::string& cmd, char* value, void* userdata, int line)
-                      {
-                        assert(cmd == "COMMAND_two");
-                        assert(userdata == nullptr);
-                        cout <<std::endl<< "line#"<<line<<": the command  '"<<cmd<<"' got the value '"<<value<<"'";
-                      });
-
-parser.set_unexpected_cmd_handler(nullptr,[](const std::string& cmd, char* value, void* userdata, int line)
-                    {
-                        cout <<std::endl<<"line#"<<line<<": unhandled command  '"<<cmd<<"' got the value '"<<value<<"'";
-                    });
-
-parser.parse("my_config_file.cfg");
-~~~~~~~~~~
-
-The output should look like:
-~~~~~~~~~~
-line#2: the command 'COMMAND_ONE' got the value ' this is value  '
-line#3: the command 'COMMAND_two' got the value 'ETH 1 0 20 15    '
-line#4: unhandled command  'cOmMaNd_tHrEe' got the value ' dummy'
-~~~~~~~~~~
-
-## Commands Provider ##
-the opt_parser_t#init method is designed to register commands parsers for a particular use.
-This last should provide a static method #register_command which does the commands registering.
-class #config_parser_filler_t is a good example on how this collaboration is done.
-\see config_parser_filler_t#register_commands, config_t#load
-*/
-struct opt_parser_t
-{
-    /**
-    * \brief One single command parser
-    */
-    struct command_parser_t
-    {
-        std::string command;                                                    //!< concerned command
-        std::function<bool(const std::string&, char*, void*,int)> callback;     //!< user defined callback
-        void* user_data;                                                        //!< user defined data
-
-        command_parser_t() :
-            command("dummy")
-            , callback(nullptr)
-            , user_data(nullptr)
-            {}
-
-        command_parser_t(const command_parser_t& other)
-            :
-              command(other.command)
-            , callback(other.callback)
-            , user_data(other.user_data)
-        {}
-
-        const command_parser_t& operator=(const command_parser_t& rhs)
-        {
-            command=rhs.command;
-            callback=rhs.callback;
-            user_data=rhs.user_data;
-            return *this;
-        }
-
-        ~command_parser_t(){}
-    };
-
-    std::vector<command_parser_t>   commands;           //!< commands parser
-    command_parser_t                unknown;            //!< callback this for any unknown command
-    int                             lineno;             //!< current line number in parsed file
-    void*                           user_data;          //!< global user data
-
-
-    opt_parser_t():
-          commands()
-        , unknown()
-        , lineno(0)
-        , user_data(nullptr)
-    {}
-
-    ~opt_parser_t(){}
-
-
-    template<class filler_t>
-    void init(void* ud=nullptr)
-    {
-        user_data = ud;
-        filler_t::register_commands(*this);
-    }
-
-    /**
-    * \brief parse commands from the input stream
-    * \param [in,out] input: input stream
-    * \return useless
-    */
-    bool parse(std::istream& input);
-    /**
-    * \brief parse commands filename
-    * \param [in] filename: input file name
-    * \return useless
-    */
-    bool parse(const std::string& filename);
-
-    /**
-    * \brief register a new command, with user data, and a callback function
-    * \param [in] cmd: command name
-    * \param [in,out] userdata: user data to be passed to the callback function
-    * \param [in] callback: function to call
-    * the callback function receives four arguments:
-    *    - cmd: the command (assignment's left-hand-side)
-    *    - val: the value (assignment's right hand side)
-    *    - userdata: the registered user data
-    *    - line: line number in file
-    */
-    void add_cmd_parser(const std::string& cmd, void* userdata
-                , const std::function<bool(const std::string& cmd,char* val,void* userdata,int line)>& callback);
-
-    /**
-    * \brief register a callback for unregistered commands
-    * \param [in,out] userdata: user data to be passed to the callback function
-    * \param [in] callback: function to call
-    */
-    void set_unexpected_cmd_handler(void* userdata, const std::function<bool(const std::string&,char*,void*,int)>& callback);
-
-private:
-    /**
-    * \brief parse one single line
-    * \param [in,out] line
-    * \param [in,out] interrupt: unused
-    */
-    bool parse_line(char* line, bool& interrupt);
-
-    /**
-    * \brief call the callback corresponding to a command
-    * \param [in] command: the current command
-    * \param [in,out] value: the corresponding value
-    * \param [in,out] interrupt: unused
-    */
-    bool __user_value_parser(const std::string& command,char* value, bool& interrupt);
-
-    opt_parser_t(const opt_parser_t&) :
-        commands()
-        , unknown()
-        , lineno(0)
-        , user_data(nullptr)
-    {GO_UNREACHABLE();}
-    const opt_parser_t& operator=(const opt_parser_t&) {GO_UNREACHABLE();}
-
-};
-
-} /* namespace mparsers */
-/**
- * @}
- */
-
-#endif // VAR_ASSIGN_PARSER_T_HEADER_INC
+#endif
+
+namespace mparsers
+{
+
+namespace detail
+{
+    //!< @brief value names of a bound enumeration, and their underlying values
+    typedef std::vector<std::pair<std::string, long long>> bind_names_t;
+
+    /** \brief types opt_parser_t#bind converts values to
+     */
+    template <class T>
+    struct is_bindable : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> {};
+
+    template <>
+    struct is_bindable<std::string> : std::true_type {};
+
+    template <class T>
+    struct is_bindable<std::vector<T>> : std::integral_constant<bool, is_bindable<T>::value
+                                                                     && !std::is_same<T, bool>::value> {};
+
+    /** \brief element type of a bound variable: the variable type itself, or the type of a vector elements */
+    template <class T>
+    struct bind_element {typedef T type;};
+
+    template <class T>
+    struct bind_element<std::vector<T>> {typedef T type;};
+
+    /** \brief case insensitive comparison with a lower case word */
+    inline bool equals_lower(std::string_view value, std::string_view lower)
+    {
+        if(value.size() != lower.size())
+            return false;
+        for(size_t it=0; it < value.size(); ++it)
+            if((value[it] | 0x20) != lower[it])
+                return false;
+        return true;
+    }
+
+    /** \brief convert a trimmed command value, without allocating (except for std::string)
+     * numbers are read with std::from_chars and must consume the whole value. Booleans are 1/0, true/false,
+     * yes/no or on/off in any case, and an empty value is true: "FLAG" alone sets FLAG. Enumerations are one
+     * of their names, or their underlying value.
+     * \param [in] value: trimmed value, empty if the command has none
+     * \param [out] out: converted value, left untouched on failure
+     * \param [in] names: names of the enumeration values, unused for the other types
+     * \return false if the value can not be converted
+     */
+    template <class T>
+    inline bool bind_value(std::string_view value, T& out, const bind_names_t& names)
+    {
+        if constexpr (std::is_same<T, bool>::value)
+        {
+            if(value.empty() || value == "1" || equals_lower(value, "true") || equals_lower(value, "yes")
+               || equals_lower(value, "on"))
+                out = true;
+            else if(value == "0" || equals_lower(value, "false") || equals_lower(value, "no")
+                    || equals_lower(value, "off"))
+                out = false;
+            else
+                return false;
+            return true;
+        }
+        else if constexpr (std::is_enum<T>::value)
+        {
+            for(const auto& name : names)
+            {
+                if(name.first == value)
+                {
+                    out = static_cast<T>(name.second);
+                    return true;
+                }
+            }
+            std::underlying_type_t<T> number;
+            if(value.empty() || convert_field(value, number) != std::errc())
+                return false;
+            out = static_cast<T>(number);
+            return true;
+        }
+        else
+        {
+            T number;
+            if(value.empty() || convert_field(value, number) != std::errc())
+                return false;
+            out = number;
+            return true;
+        }
+    }
+
+    //!< @brief strings get the whole trimmed value
+    inline bool bind_value(std::string_view value, std::string& out, const bind_names_t&)
+    {
+        out.assign(value.data(), value.size());
+        return true;
+    }
+
+    /** \brief vectors get one element per blank separated word. Elements keep their storage from one line to
+     * another. On failure, the elements before the failing word are converted, and the vector ends there.
+     */
+    template <class T>
+    inline bool bind_value(std::string_view value, std::vector<T>& out, const bind_names_t& names)
+    {
+        size_t count = 0;
+        size_t it = 0;
+        bool valid = true;
+        while(valid)
+        {
+            it = value.find_first_not_of(" \t", it);
+            if(it == std::string_view::npos)
+                break;
+            const size_t end = std::min(value.find_first_of(" \t", it), value.size());
+            if(count == out.size())
+                out.emplace_back();
+            valid = bind_value(value.substr(it, end - it), out[count], names);
+            count += valid;
+            it = end;
+        }
+        out.resize(count);
+        return valid;
+    }
+} /* namespace detail */
+
+/**
+ * \defgroup parsers_group Parsers
+ * \brief some useful parsers
+ * @{
+ * \file var_assign_parser.h
+ * \brief parser for variable assignment sequence file.
+ * \author Marouane BELAOUCHA
+ */
+
+
+/**
+ *  \brief option file parser
+
+## How To Use? ##
+ The file to parse is a sequence of variable assignment commands of this form:
+~~~~~~~~~~
+1:    # this is a comment
+2:    COMMAND_ONE = this is value  ; this will be ignored
+3:    COMMAND_two = ETH 1 0 20 15    # this will be ignored
+4:    cOmMaNd_tHrEe = dummy
+    ...
+~~~~~~~~~~
+Here characters ';' and '#' are used as comment starters, with effect till the end of line.
+The #opt_parser_t parser iterates over file's lines looking for assignments. The assignment
+left hand side denotes the command name (case sensitive) which should be registered using
+opt_parser_t#add_cmd_parser, before paring with  opt_parser_t#parse.
+
+The input seen by parser for the example above is:
+~~~~~~~~~~
+1:
+2:    COMMAND_ONE = this is value
+3:    COMMAND_two = ETH 1 0 20 15
+4:    cOmMaNd_tHrEe = dummy
+    ...
+~~~~~~~~~~
+
+A parser for such file could be initialized this way:
+
+~~~~~~~~~~
+opt_parser_t parser;
+...
+parser.add_cmd_parser("COMMAND_ONE", nullptr, [](const std::string& cmd, char* value, void* userdata, int line)
+                      {
+                        assert(cmd == "COMMAND_ONE");
+                        assert(userdata == nullptr);
+                        cout <<std::endl<< "line#"<<line<<": the command  '"<<cmd<<"' got the value '"<<value<<"'";
+                      });
+
+parser.add_cmd_parser("COMMAND_two", nullptr, [](const std::string& cmd, char* value, void* userdata, int line)
+                      {
+                        assert(cmd == "COMMAND_two");
+                        assert(userdata == nullptr);
+                        cout <<std::endl<< "line#"<<line<<": the command  '"<<cmd<<"' got the value '"<<value<<"'";
+                      });
+
+parser.set_unexpected_cmd_handler(nullptr,[](const std::string& cmd, char* value, void* userdata, int line)
+                    {
+                        cout <<std::endl<<"line#"<<line<<": unhandled command  '"<<cmd<<"' got the value '"<<value<<"'";
+                    });
+
+parser.parse("my_config_file.cfg");
+~~~~~~~~~~
+
+The output should look like:
+~~~~~~~~~~
+line#2: the command 'COMMAND_ONE' got the value ' this is value  '
+line#3: the command 'COMMAND_two' got the value 'ETH 1 0 20 15    '
+line#4: unhandled command  'cOmMaNd_tHrEe' got the value ' dummy'
+~~~~~~~~~~
+
+## Typed Bindings ##
+Most commands only store their value. opt_parser_t#bind does it without any callback: the value is trimmed and
+converted straight from the line buffer (with std::from_chars for numbers), into a variable which must outlive the
+parser. Integers, floating points, bools, std::string, enumerations, and std::vector of them (one element per
+blank separated word) can be bound:
+
+~~~~~~~~~~
+int threads = 1;
+double ratio = 0.5;
+bool verbose = false;
+std::vector<std::string> route;
+enum class run_mode_t {FAST, SAFE} mode = run_mode_t::FAST;
+
+parser.bind("THREADS", &threads);
+parser.bind("RATIO", &ratio);
+parser.bind("VERBOSE", &verbose);           // "VERBOSE" alone, or VERBOSE = yes
+parser.bind("COMMAND_two", &route);         // {"ETH", "1", "0", "20", "15"}
+parser.bind("MODE", &mode, {{"fast", run_mode_t::FAST}, {"safe", run_mode_t::SAFE}});
+parser.set_bind_error_handler(nullptr, [](const std::string& cmd, char* value, void*, int line)
+                    {
+                        cerr<<"line#"<<line<<": bad value for '"<<cmd<<"': "<<(value ? value : "");
+                        return true;        // interrupt
+                    });
+~~~~~~~~~~
+
+## Commands Provider ##
+the opt_parser_t#init method is designed to register commands parsers for a particular use.
+This last should provide a static method #register_command which does the commands registering.
+class #config_parser_filler_t is a good example on how this collaboration is done.
+A filler can also declare its commands at compile time with a command_table_t typedef named command_table,
+avoiding both the registration cost and the std::function indirection (see command_table.h).
+\see config_parser_filler_t#register_commands, config_t#load
+*/
+struct opt_parser_t
+{
+    /**
+    * \brief One single command parser
+    */
+    struct command_parser_t
+    {
+        std::string command;                                                    //!< concerned command
+        std::function<bool(const std::string&, char*, void*,int)> callback;     //!< user defined callback
+        void* user_data;                                                        //!< user defined data
+        bool (*assign)(std::string_view, void*);    //!< typed binding converting the value into user_data, or null
+
+        command_parser_t() :
+            command("dummy")
+            , callback(nullptr)
+            , user_data(nullptr)
+            , assign(nullptr)
+            {}
+
+        command_parser_t(const command_parser_t& other)
+            :
+              command(other.command)
+            , callback(other.callback)
+            , user_data(other.user_data)
+            , assign(other.assign)
+        {}
+
+        const command_parser_t& operator=(const command_parser_t& rhs)
+        {
+            command=rhs.command;
+            callback=rhs.callback;
+            user_data=rhs.user_data;
+            assign=rhs.assign;
+            return *this;
+        }
+
+        ~command_parser_t(){}
+    };
+
+    std::vector<command_parser_t>   commands;           //!< commands parser
+    command_parser_t                unknown;            //!< callback this for any unknown command
+    command_parser_t                bind_error;         //!< callback this for any value a binding can not convert
+    int                             lineno;             //!< current line number in parsed file
+    void*                           user_data;          //!< global user data
+
+
+    opt_parser_t():
+          commands()
+        , unknown()
+        , bind_error()
+        , lineno(0)
+        , user_data(nullptr)
+        , bindings()
+        , command_index()
+        , indexed_commands(nullptr)
+        , indexed_count(0)
+        , static_dispatch(nullptr)
+    {}
+
+    ~opt_parser_t(){}
+
+
+    /**
+    * \brief register the commands of a filler
+    * the filler may declare a compile-time command_table_t typedef named command_table: its handlers are called
+    * directly, receiving ud as user data, and take precedence over commands registered at runtime.
+    * It may also (or instead) provide a static register_commands(opt_parser_t&) method, which is called.
+    * \param [in,out] ud: global user data
+    */
+    template<class filler_t>
+    void init(void* ud=nullptr)
+    {
+        static_assert(has_command_table<filler_t>::value || has_register_commands<filler_t>::value
+                      , "filler_t needs a command_table typedef or a register_commands method");
+        user_data = ud;
+        if constexpr (has_command_table<filler_t>::value)
+            static_dispatch = &filler_t::command_table::dispatch;
+        if constexpr (has_register_commands<filler_t>::value)
+            filler_t::register_commands(*this);
+    }
+
+    /**
+    * \brief parse commands from the input stream
+    * \param [in,out] input: input stream
+    * \return useless
+    */
+    bool parse(std::istream& input);
+    /**
+    * \brief parse commands filename. gzip and zstd files are decompressed on the fly, by a separate thread
+    * \param [in] filename: input file name
+    * \return false if the file can not be read, is a corrupted or truncated archive (the commands before the
+    * damage are still parsed), or a callback interrupted the parse
+    */
+    bool parse(const std::string& filename);
+    /**
+    * \brief parse commands from the input stream, collecting statistics
+    * \param [in,out] input: input stream
+    * \param [in,out] stats: receives the counters and timings of the parse, added to the ones it holds
+    * \return false if a callback interrupted the parse
+    */
+    bool parse(std::istream& input, collect_stats_t& stats);
+    /**
+    * \brief parse commands filename, collecting statistics
+    * \param [in] filename: input file name
+    * \param [in,out] stats: receives the counters and timings of the parse, added to the ones it holds
+    * \return false if the file can not be read, is a corrupted or truncated archive, or a callback interrupted
+    * the parse
+    */
+    bool parse(const std::string& filename, collect_stats_t& stats);
+
+    /**
+    * \brief register a new command, with user data, and a callback function
+    * \param [in] cmd: command name
+    * \param [in,out] userdata: user data to be passed to the callback function
+    * \param [in] callback: function to call
+    * the callback function receives four arguments:
+    *    - cmd: the command (assignment's left-hand-side)
+    *    - val: the value (assignment's right hand side)
+    *    - userdata: the registered user data
+    *    - line: line number in file
+    */
+    void add_cmd_parser(const std::string& cmd, void* userdata
+                , const std::function<bool(const std::string& cmd,char* val,void* userdata,int line)>& callback);
+
+    /**
+    * \brief register a callback for unregistered commands
+    * \param [in,out] userdata: user data to be passed to the callback function
+    * \param [in] callback: function to call
+    */
+    void set_unexpected_cmd_handler(void* userdata, const std::function<bool(const std::string&,char*,void*,int)>& callback);
+
+    /**
+    * \brief bind a command to a variable: its value is converted and stored, without any callback.
+    * The value is trimmed, then converted in place (see detail::bind_value): integers and floating points with
+    * std::from_chars, bools, std::string, enumerations (through their underlying value), and std::vector of
+    * them, one element per blank separated word. A value which can not be converted leaves the variable
+    * untouched (a vector keeps the elements before the faulty word), and is reported to the bind error handler.
+    * With parse_many, every file writes the same variables: the writes to a variable are serialized, and the
+    * value it keeps comes from whichever file set it last, in no particular order.
+    * \param [in] cmd: command name
+    * \param [in,out] target: variable receiving the values, must outlive the parser
+    */
+    template <class T>
+    void bind(const std::string& cmd, T* target)
+    {
+        static_assert(detail::is_bindable<T>::value
+                      , "bind needs a number, a bool, an enum, a std::string, or a std::vector of them");
+        add_binding(cmd, target, detail::bind_names_t(), &assign_value<T>);
+    }
+
+    /**
+    * \brief bind a command to an enumeration variable (or a std::vector of them), its values being given by names
+    * \param [in] cmd: command name
+    * \param [in,out] target: variable receiving the values, must outlive the parser
+    * \param [in] names: value of each name. Values may also be given as numbers
+    */
+    template <class T>
+    void bind(const std::string& cmd, T* target
+              , const std::vector<std::pair<std::string, typename detail::bind_element<T>::type>>& names)
+    {
+        static_assert(std::is_enum<typename detail::bind_element<T>::type>::value
+                      , "named values need an enum, or a std::vector of an enum");
+        detail::bind_names_t numbers;
+        for(const auto& name : names)
+            numbers.emplace_back(name.first, (long long)name.second);
+        add_binding(cmd, target, numbers, &assign_value<T>);
+    }
+
+    /**
+    * \brief register a callback for the values bindings can not convert
+    * \param [in,out] userdata: user data to be passed to the callback function
+    * \param [in] callback: function to call, its result interrupts the parse when true
+    * the callback function receives four arguments:
+    *    - cmd: the bound command
+    *    - val: the value which could not be converted, null if the command came without a value
+    *    - userdata: the registered user data
+    *    - line: line number
+    */
+    void set_bind_error_handler(void* userdata, const std::function<bool(const std::string&,char*,void*,int)>& callback);
+
+    /**
+    * \brief build the command dispatch index.
+    * parse() calls it whenever commands were added since the last index build, so calling it is only useful to
+    * pay the indexing cost ahead of time. When a command is registered twice, the first registration wins.
+    */
+    void freeze();
+
+    /**
+    * \brief call the callback registered for a command, or the unexpected command handler
+    * \param [in] command: command name
+    * \param [in,out] value: command value, may be null
+    * \param [in] line: line number given to the callback
+    * \return the callback result: true asks to interrupt the parse
+    */
+    bool dispatch(std::string_view command, char* value, int line);
+
+    /**
+    * \brief split an assignment line in place, without hidden state (unlike strtok)
+    * comments ('#' or ';') are cut, the command is trimmed, and the value is left untrimmed.
+    * \param [in,out] line: line to split, modified in place
+    * \param [out] command: command name, not empty on success
+    * \param [out] value: command value, null when there is no '=' or nothing after it
+    * \return false if the line holds no command
+    */
+    static bool tokenize(char* line, char*& command, char*& value);
+
+    /**
+    * \brief outcome of parsing one file with parse_many
+    */
+    struct parse_result_t
+    {
+        std::string         filename;       //!< parsed file
+        bool                opened;         //!< the file could be opened
+        bool                interrupted;    //!< a callback interrupted the parse
+        bool                failed;         //!< the file is a corrupted or truncated archive, read up to the damage
+        int                 lines;          //!< number of lines read
+        std::exception_ptr  error;          //!< exception thrown by a callback, if any
+        parse_stats_t       stats;          //!< statistics of the parse, when collected
+
+        parse_result_t(): filename(), opened(false), interrupted(false), failed(false), lines(0), error(), stats() {}
+    };
+
+    /**
+    * \brief parse many files in parallel, sharing the same (frozen) commands
+    * the dispatch index is built once, then files are parsed by the pool workers. Callbacks are called
+    * concurrently from several threads, with the line number of their own file: they have to be thread safe.
+    * lineno is not updated.
+    * \param [in] filenames: files to parse
+    * \param [in,out] pool: worker threads
+    * \param [in] collect_stats: fill the stats of each result
+    * \return one result per file, in the same order as filenames
+    */
+    std::vector<parse_result_t> parse_many(const std::vector<std::string>& filenames, thread_pool_t& pool
+                                           , bool collect_stats = false);
+
+private:
+    /**
+    * \brief variable bound to a command
+    */
+    struct binding_t
+    {
+        void*                   target; //!< bound variable
+        detail::bind_names_t    names;  //!< names of the enumeration values, if any
+        std::mutex              lock;   //!< serializes the writes of parse_many workers to target
+
+        binding_t(void* t, const detail::bind_names_t& n): target(t), names(n), lock() {}
+
+    private:
+        binding_t(const binding_t&): target(nullptr), names(), lock() {GO_UNREACHABLE();}
+        const binding_t& operator=(const binding_t&) {GO_UNREACHABLE(); return *this;}
+    };
+
+    //!< @brief convert a value into the variable of a binding_t
+    template <class T>
+    static bool assign_value(std::string_view value, void* binding)
+    {
+        binding_t& bound = *static_cast<binding_t*>(binding);
+        std::lock_guard<std::mutex> guard(bound.lock);
+        return detail::bind_value(trim_view(value), *static_cast<T*>(bound.target), bound.names);
+    }
+
+    /**
+    * \brief register a binding as a command
+    * \param [in] cmd: command name
+    * \param [in,out] target: bound variable
+    * \param [in] names: names of the enumeration values, if any
+    * \param [in] assign: value converter
+    */
+    void add_binding(const std::string& cmd, void* target, const detail::bind_names_t& names
+                     , bool (*assign)(std::string_view, void*));
+
+    /**
+    * \brief parse commands from an input source
+    * \param [in,out] source: input
+    * \param [in,out] stats: statistics policy
+    * \return false if a callback interrupted the parse
+    */
+    template <class stats_t>
+    bool parse_source(input_source_t& source, stats_t& stats);
+
+    /**
+    * \brief parse commands from a line reader, without touching the parser state
+    * \param [in,out] reader: input lines
+    * \param [in] timed: source of the reader, telling the time spent reading
+    * \param [in,out] line: current line number
+    * \param [in,out] stats: statistics policy
+    * \return false if a callback interrupted the parse
+    */
+    template <class stats_t>
+    bool parse_lines(block_reader_t& reader, const timed_source_t<stats_t>& timed, int& line, stats_t& stats) const;
+
+    /**
+    * \brief parse one single line
+    * \param [in,out] line: line content, modified in place
+    * \param [in] line_number: line number in file
+    * \param [in,out] interrupt: set by the callback
+    * \param [in,out] stats: statistics policy
+    */
+    template <class stats_t>
+    bool parse_line(char* line, int line_number, bool& interrupt, stats_t& stats) const;
+
+    /**
+    * \brief call the callback corresponding to a command
+    * \param [in] command: the current command
+    * \param [in,out] value: the corresponding value
+    * \param [in] line: line number in file
+    * \param [in,out] interrupt: set by the callback
+    */
+    bool __user_value_parser(std::string_view command,char* value, int line, bool& interrupt) const;
+
+    /**
+    * \brief is the dispatch index in sync with commands?
+    */
+    inline bool is_frozen() const {return indexed_commands == commands.data() && indexed_count == commands.size();}
+
+    std::deque<binding_t>                           bindings;           //!< bound variables, user data of their commands
+    std::unordered_map<std::string_view, size_t>    command_index;      //!< command name -> index in commands
+    const command_parser_t*                         indexed_commands;   //!< commands storage when indexed
+    size_t                                          indexed_count;      //!< commands count when indexed
+    bool (*static_dispatch)(std::string_view, char*, void*, int, bool&);  //!< compile-time command table, if any
+
+    opt_parser_t(const opt_parser_t&) :
+        commands()
+        , unknown()
+        , bind_error()
+        , lineno(0)
+        , user_data(nullptr)
+        , bindings()
+        , command_index()
+        , indexed_commands(nullptr)
+        , indexed_count(0)
+        , static_dispatch(nullptr)
+    {GO_UNREACHABLE();}
+    const opt_parser_t& operator=(const opt_parser_t&) {GO_UNREACHABLE();}
+
+};
+
+} /* namespace mparsers */
+/**
+ * @}
+ */
+
+#endif // VAR_ASSIGN_PARSER_T_HEADER_INC
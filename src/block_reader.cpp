@@ -0,0 +1,115 @@
+#include <cstring>
+#include <parsers/block_reader.h>
+
+using namespace mparsers;
+
+size_t stream_source_t::read(char* buffer, size_t size)
+{
+    if(!input.good())
+        return 0;
+    input.read(buffer, size);
+    return input.gcount();
+}
+
+file_source_t::~file_source_t()
+{
+    if(file)
+        fclose(file);
+}
+
+bool file_source_t::open(const std::string& fn)
+{
+    if(file)
+        fclose(file);
+    file = fopen(fn.c_str(), "rb");
+    if(!file)
+        return false;
+    /* reads are already large: let them go straight to the system */
+    setvbuf(file, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool file_source_t::seek(uint64_t offset)
+{
+#ifdef _WIN32
+    return file && _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return file && fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+size_t file_source_t::read(char* buffer, size_t size)
+{
+    return file ? fread(buffer, 1, size, file) : 0;
+}
+
+block_reader_t::block_reader_t(input_source_t& src, size_t block_size):
+      source(src)
+    , buffer(new char[(block_size ? block_size : 1) + 1])
+    , capacity(block_size ? block_size : 1)
+    , head(0)
+    , tail(0)
+    , searched(0)
+    , total(0)
+    , eof(false)
+{}
+
+bool block_reader_t::next_line(char*& line, size_t& length)
+{
+    for(;;)
+    {
+        char* data = buffer.get();
+        const size_t from = head + searched;
+        char* nl = static_cast<char*>(memchr(data + from, '\n', tail - from));
+        if(nl)
+        {
+            *nl = 0;
+            line = data + head;
+            length = nl - line;
+            head = nl + 1 - data;
+            searched = 0;
+            return true;
+        }
+        searched = tail - head;
+        if(!refill())
+        {
+            if(tail == head)
+                return false;
+            data = buffer.get();
+            data[tail] = 0;
+            line = data + head;
+            length = tail - head;
+            head = tail;
+            searched = 0;
+            return true;
+        }
+    }
+}
+
+bool block_reader_t::refill()
+{
+    if(eof)
+        return false;
+    if(head)
+    {
+        memmove(buffer.get(), buffer.get() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+    if(tail == capacity)
+    {
+        std::unique_ptr<char[]> larger(new char[2 * capacity + 1]);
+        memcpy(larger.get(), buffer.get(), tail);
+        buffer.swap(larger);
+        capacity *= 2;
+    }
+    const size_t n = source.read(buffer.get() + tail, capacity - tail);
+    if(!n)
+    {
+        eof = true;
+        return false;
+    }
+    tail += n;
+    total += n;
+    return true;
+}
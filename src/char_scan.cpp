@@ -0,0 +1,33 @@
+#include <parsers/char_scan.h>
+
+namespace mparsers
+{
+    static simd_level_t detect_simd_level()
+    {
+#ifdef MPARSERS_HAVE_X86_SIMD
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            return SIMD_AVX2;
+        if(__builtin_cpu_supports("sse2"))
+            return SIMD_SSE2;
+#endif
+        return SIMD_SCALAR;
+    }
+
+    static simd_level_t& current_simd_level()
+    {
+        static simd_level_t level = detect_simd_level();
+        return level;
+    }
+
+    simd_level_t simd_level()
+    {
+        return current_simd_level();
+    }
+
+    void set_simd_level(simd_level_t level)
+    {
+        static const simd_level_t supported = detect_simd_level();
+        current_simd_level() = level < supported ? level : supported;
+    }
+} /*namespace mparsers*/
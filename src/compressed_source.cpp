@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <parsers/compressed_source.h>
+
+#ifdef MPARSERS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MPARSERS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace mparsers;
+
+/** \brief decompresses a file, block after block
+ */
+struct decompress_source_t::decoder_t
+{
+    static const size_t input_size = 256 << 10;    //!< compressed bytes read at once
+
+    decoder_t(): file(nullptr), input(new char[input_size]) {}
+    virtual ~decoder_t()
+    {
+        if(file)
+            fclose(file);
+    }
+
+    /**
+    * \brief decompress up to size bytes
+    * \param [out] out: destination
+    * \param [in] size: room in out
+    * \param [out] end: true once the whole file is decompressed, or once the stream turns out unreadable
+    * \param [out] failed: true if the stream is corrupted or truncated
+    * \return number of decompressed bytes, including the ones decompressed before a failure
+    */
+    virtual size_t decode(char* out, size_t size, bool& end, bool& failed) = 0;
+
+    FILE*                   file;   //!< compressed file
+    std::unique_ptr<char[]> input;  //!< compressed bytes
+
+private:
+    decoder_t(const decoder_t&): file(nullptr), input() {GO_UNREACHABLE();}
+    const decoder_t& operator=(const decoder_t&) {GO_UNREACHABLE(); return *this;}
+};
+
+namespace
+{
+#ifdef MPARSERS_HAVE_ZLIB
+    /** \brief gzip decompressor, following concatenated members
+     */
+    struct gzip_decoder_t : public decompress_source_t::decoder_t
+    {
+        gzip_decoder_t(): stream(), initialized(false), between_members(false)
+        {
+            memset(&stream, 0, sizeof(stream));
+            initialized = inflateInit2(&stream, 15 + 32) == Z_OK;
+        }
+        ~gzip_decoder_t() override
+        {
+            if(initialized)
+                inflateEnd(&stream);
+        }
+
+        size_t decode(char* out, size_t size, bool& end, bool& failed) override
+        {
+            if(!initialized)
+            {
+                end = failed = true;
+                return 0;
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(out);
+            stream.avail_out = (uInt)size;
+            while(stream.avail_out)
+            {
+                if(!stream.avail_in)
+                {
+                    stream.avail_in = (uInt)fread(input.get(), 1, input_size, file);
+                    stream.next_in = reinterpret_cast<Bytef*>(input.get());
+                    if(!stream.avail_in)
+                    {
+                        end = true;
+                        failed = !between_members;
+                        break;
+                    }
+                }
+                const int status = inflate(&stream, Z_NO_FLUSH);
+                between_members = false;
+                if(status == Z_STREAM_END)
+                {
+                    between_members = true;
+                    inflateReset(&stream);
+                }
+                else if(status != Z_OK && status != Z_BUF_ERROR)
+                {
+                    end = failed = true;
+                    break;
+                }
+            }
+            return size - stream.avail_out;
+        }
+
+        z_stream    stream;             //!< zlib state
+        bool        initialized;        //!< stream is usable
+        bool        between_members;    //!< the last member is complete
+    };
+#endif
+
+#ifdef MPARSERS_HAVE_ZSTD
+    /** \brief zstd decompressor, following concatenated frames
+     */
+    struct zstd_decoder_t : public decompress_source_t::decoder_t
+    {
+        zstd_decoder_t(): stream(ZSTD_createDStream()), in{nullptr, 0, 0}, frame_done(true) {}
+        ~zstd_decoder_t() override {ZSTD_freeDStream(stream);}
+
+        size_t decode(char* out, size_t size, bool& end, bool& failed) override
+        {
+            if(!stream)
+            {
+                end = failed = true;
+                return 0;
+            }
+            ZSTD_outBuffer output = {out, size, 0};
+            while(output.pos < output.size)
+            {
+                if(in.pos == in.size)
+                {
+                    in.size = fread(input.get(), 1, input_size, file);
+                    in.src = input.get();
+                    in.pos = 0;
+                    if(!in.size)
+                    {
+                        end = true;
+                        failed = !frame_done;
+                        break;
+                    }
+                }
+                const size_t status = ZSTD_decompressStream(stream, &output, &in);
+                if(ZSTD_isError(status))
+                {
+                    end = failed = true;
+                    break;
+                }
+                frame_done = status == 0;
+            }
+            return output.pos;
+        }
+
+        ZSTD_DStream*   stream;     //!< zstd state
+        ZSTD_inBuffer   in;         //!< compressed bytes window
+        bool            frame_done; //!< the last frame is complete
+    };
+#endif
+} /* namespace */
+
+compression_t mparsers::detect_compression(const std::string& fn)
+{
+    unsigned char magic[4] = {0, 0, 0, 0};
+    FILE* file = fopen(fn.c_str(), "rb");
+    if(!file)
+        return COMPRESSION_NONE;
+    const size_t n = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    if(n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        return COMPRESSION_GZIP;
+    if(n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        return COMPRESSION_ZSTD;
+    return COMPRESSION_NONE;
+}
+
+bool mparsers::compression_supported(compression_t format)
+{
+    switch(format)
+    {
+        case COMPRESSION_NONE: return true;
+        case COMPRESSION_GZIP:
+#ifdef MPARSERS_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case COMPRESSION_ZSTD:
+#ifdef MPARSERS_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default: return false;
+    }
+}
+
+decompress_source_t::decompress_source_t(size_t size):
+      input_source_t()
+    , decoder(nullptr)
+    , blocks()
+    , block_size(size ? size : 1)
+    , ready(0)
+    , producing(0)
+    , consuming(0)
+    , position(0)
+    , finished(true)
+    , stopping(false)
+    , error(false)
+    , lock()
+    , changed()
+    , worker()
+{}
+
+decompress_source_t::~decompress_source_t()
+{
+    stop();
+    delete decoder;
+}
+
+bool decompress_source_t::open(const std::string& fn)
+{
+    stop();
+    delete decoder;
+    decoder = nullptr;
+    switch(detect_compression(fn))
+    {
+        case COMPRESSION_NONE: return false;
+        case COMPRESSION_GZIP:
+#ifdef MPARSERS_HAVE_ZLIB
+            decoder = new gzip_decoder_t();
+            break;
+#else
+            return false;
+#endif
+        case COMPRESSION_ZSTD:
+#ifdef MPARSERS_HAVE_ZSTD
+            decoder = new zstd_decoder_t();
+            break;
+#else
+            return false;
+#endif
+        default: return false;
+    }
+    decoder->file = fopen(fn.c_str(), "rb");
+    if(!decoder->file)
+    {
+        delete decoder;
+        decoder = nullptr;
+        return false;
+    }
+    setvbuf(decoder->file, nullptr, _IONBF, 0);
+    for(int it=0; it < 2; ++it)
+    {
+        if(!blocks[it].data)
+            blocks[it].data.reset(new char[block_size]);
+        blocks[it].size = 0;
+    }
+    ready = 0;
+    producing = 0;
+    consuming = 0;
+    position = 0;
+    finished = false;
+    stopping = false;
+    error = false;
+    worker = std::thread(&decompress_source_t::produce, this);
+    return true;
+}
+
+size_t decompress_source_t::read(char* buffer, size_t size)
+{
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]{return ready > 0 || finished;});
+        if(!ready)
+            return 0;
+    }
+    block_t& block = blocks[consuming];
+    const size_t n = std::min(size, block.size - position);
+    memcpy(buffer, block.data.get() + position, n);
+    position += n;
+    if(position == block.size)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        position = 0;
+        consuming ^= 1;
+        ready--;
+        changed.notify_all();
+    }
+    /* an empty block only marks the end: read the next one, if any */
+    return n ? n : read(buffer, size);
+}
+
+bool decompress_source_t::failed() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return error;
+}
+
+void decompress_source_t::produce()
+{
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [this]{return ready < 2 || stopping;});
+            if(stopping)
+                return;
+        }
+        block_t& block = blocks[producing];
+        bool end = false;
+        bool failure = false;
+        /* bytes decompressed before a failure are published too: only the unreadable part is lost */
+        const size_t n = decoder->decode(block.data.get(), block_size, end, failure);
+
+        std::lock_guard<std::mutex> guard(lock);
+        block.size = n;
+        ready++;
+        producing ^= 1;
+        if(failure)
+            error = true;
+        if(end)
+            finished = true;
+        changed.notify_all();
+        if(finished)
+            return;
+    }
+}
+
+void decompress_source_t::stop()
+{
+    if(!worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        changed.notify_all();
+    }
+    worker.join();
+    finished = true;
+    ready = 0;
+}
+
+bool auto_file_source_t::open(const std::string& fn)
+{
+    format = detect_compression(fn);
+    return format == COMPRESSION_NONE ? plain.open(fn) : archive.open(fn);
+}
+
+bool auto_file_source_t::failed() const
+{
+    return format != COMPRESSION_NONE && archive.failed();
+}
+
+size_t auto_file_source_t::read(char* buffer, size_t size)
+{
+    return format == COMPRESSION_NONE ? plain.read(buffer, size) : archive.read(buffer, size);
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <parsers/line_index.h>
+
+using namespace mparsers;
+
+namespace
+{
+    const char magic[8] = {'M','P','L','I','D','X','0','1'};
+
+    /** \brief fixed part of an index file, followed by the offsets
+     */
+    struct header_t
+    {
+        char        magic[8];
+        int64_t     stride;
+        int64_t     lines;
+        uint64_t    file_size;
+        int64_t     file_mtime;
+        uint64_t    count;
+    };
+
+    bool stamp(const std::string& fn, uint64_t& size, int64_t& mtime)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(fn, ec);
+        if(ec)
+            return false;
+        auto t = std::filesystem::last_write_time(fn, ec);
+        if(ec)
+            return false;
+        mtime = (int64_t)t.time_since_epoch().count();
+        return true;
+    }
+} /* namespace */
+
+line_index_t::line_index_t(int stride):
+      __stride(stride > 0 ? stride : 1)
+    , __lines(-1)
+    , __file_size(0)
+    , __file_mtime(0)
+    , __offsets()
+{}
+
+void line_index_t::reset(int stride)
+{
+    __stride = stride > 0 ? stride : 1;
+    __lines = -1;
+    __file_size = 0;
+    __file_mtime = 0;
+    __offsets.clear();
+}
+
+bool line_index_t::complete(const std::string& fn, int lines)
+{
+    if(!stamp(fn, __file_size, __file_mtime))
+        return false;
+    __lines = lines;
+    return true;
+}
+
+bool line_index_t::valid_for(const std::string& fn) const
+{
+    uint64_t size;
+    int64_t mtime;
+    return __lines >= 0 && stamp(fn, size, mtime) && size == __file_size && mtime == __file_mtime;
+}
+
+bool line_index_t::locate(int line, int& indexed_line, uint64_t& offset) const
+{
+    if(__offsets.empty())
+        return false;
+    size_t entry = line > 1 ? std::min((size_t)((line - 1) / __stride), __offsets.size() - 1) : 0;
+    indexed_line = (int)entry * __stride + 1;
+    offset = __offsets[entry];
+    return true;
+}
+
+bool line_index_t::save(const std::string& fn) const
+{
+    if(__lines < 0)
+        return false;
+    FILE* file = fopen(fn.c_str(), "wb");
+    if(!file)
+        return false;
+    header_t header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.stride = __stride;
+    header.lines = __lines;
+    header.file_size = __file_size;
+    header.file_mtime = __file_mtime;
+    header.count = __offsets.size();
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                && fwrite(__offsets.data(), sizeof(uint64_t), __offsets.size(), file) == __offsets.size();
+    written = fclose(file) == 0 && written;
+    if(!written)
+        remove(fn.c_str());
+    return written;
+}
+
+bool line_index_t::load(const std::string& fn)
+{
+    reset(__stride);
+    FILE* file = fopen(fn.c_str(), "rb");
+    if(!file)
+        return false;
+    header_t header;
+    bool loaded = fread(&header, sizeof(header), 1, file) == 1 && !memcmp(header.magic, magic, sizeof(magic))
+               && header.stride > 0 && header.lines >= 0 && header.count <= (uint64_t)header.lines + 1;
+    if(loaded)
+    {
+        __offsets.resize(header.count);
+        loaded = fread(__offsets.data(), sizeof(uint64_t), __offsets.size(), file) == __offsets.size();
+    }
+    fclose(file);
+    if(!loaded)
+    {
+        reset(__stride);
+        return false;
+    }
+    __stride = (int)header.stride;
+    __lines = (int)header.lines;
+    __file_size = header.file_size;
+    __file_mtime = header.file_mtime;
+    return true;
+}
@@ -0,0 +1,80 @@
+#include <fstream>
+#include <parsers/mapped_file.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MPARSERS_HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace mparsers;
+
+mapped_file_t::mapped_file_t():
+      __data(nullptr)
+    , __size(0)
+    , __opened(false)
+    , __fallback()
+{}
+
+mapped_file_t::~mapped_file_t()
+{
+    close();
+}
+
+bool mapped_file_t::open(const std::string& fn)
+{
+    close();
+#ifdef MPARSERS_HAVE_MMAP
+    int fd = ::open(fn.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    __size = (size_t)st.st_size;
+    if(__size)
+    {
+        void* addr = mmap(nullptr, __size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED)
+        {
+            ::close(fd);
+            __size = 0;
+            return false;
+        }
+        madvise(addr, __size, MADV_SEQUENTIAL);
+        __data = static_cast<const char*>(addr);
+    }
+    ::close(fd);
+#else
+    std::ifstream ifs(fn, std::ifstream::in | std::ifstream::binary);
+    if(!ifs.good())
+        return false;
+    ifs.seekg(0, std::ios::end);
+    __fallback.resize((size_t)ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(__fallback.data(), __fallback.size());
+    __size = __fallback.size();
+    __data = __fallback.data();
+#endif
+    __opened = true;
+    return true;
+}
+
+void mapped_file_t::close()
+{
+#ifdef MPARSERS_HAVE_MMAP
+    if(__data && __size)
+        munmap(const_cast<char*>(__data), __size);
+#endif
+    __fallback.clear();
+    __data = nullptr;
+    __size = 0;
+    __opened = false;
+}
@@ -1,108 +1,301 @@
-#include <sstream>
-#include <cstring>
-#include <cstdio>
-#include <parsers/mstring_utils.h>
-
-namespace mparsers
-{
-
-    std::string build_filename(const std::string& str)
-    {
-        std::string result = str;
-        for(int it=0; it < (int)result.length(); ++it)
-        {
-            if(!isalnum(result[it]))
-                result[it]='_';
-        }
-        return result;
-    }
-    static
-    std::vector<std::string> &split(const std::string &str, char delimiter, std::vector<std::string> &items)
-    {
-        std::stringstream ss(str);
-        std::string item;
-        while (std::getline(ss, item, delimiter))
-        {
-            items.push_back(item);
-        }
-        return items;
-    }
-
-    std::vector<std::string> split(const std::string &str, char delimiter)
-    {
-        std::vector<std::string> items;
-        split(str, delimiter, items);
-        return items;
-    }
-
-    std::string ignore_comment(const std::string& str, char comment_char)
-    {
-
-        auto v=split(str,comment_char);
-        if(v.empty())
-            return "";
-        return v[0];
-    }
-
-    static bool is_blank(int c)
-    {
-        if(c == ' ' || c=='\t' || c=='\r' || c == '\n')
-            return true;
-        return false;
-    }
-
-    char* strtrim(char* s)
-    {
-        if(!s)  return nullptr;
-        char* res=s;
-
-        for(;*res;++res)
-            if(!is_blank(*res))
-                break;
-
-        int l = strlen(res);
-        char* ptr = res + l - 1;
-        for(;*ptr && ptr >= res && is_blank(*ptr);--ptr)
-            *ptr=0;
-        return res;
-    }
-
-    std::string stdstrim(const std::string& str)
-    {
-        char inbuf[1024];
-        snprintf(inbuf,sizeof(inbuf),"%s",str.c_str());
-        return std::string(strtrim(inbuf));
-    }
-
-    std::string splitpath(const std::string& filename)
-    {
-        auto last1 = filename.find_last_of('/');
-        auto last2 = filename.find_last_of('\\');
-        size_t last;
-        if(last1 == std::string::npos && last2 == std::string::npos)
-            return "";
-
-        if(last1 == std::string::npos)
-            last = last2;
-        else
-        {
-            if(last2 == std::string::npos)
-                last = last1;
-            else
-                last = std::max(last1,last2);
-        }
-        if(last == filename.size()-1)
-            return filename;
-
-        return filename.substr(0,last);
-    }
-
-    std::string splitext(const std::string& filename)
-    {
-        auto v = split(filename,'.');
-        if(v.size())
-            return v[v.size()-1];
-        return "";
-    }
-} /*namespace mparsers*/
-
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <parsers/mstring_utils.h>
+#include <parsers/char_scan.h>
+
+namespace mparsers
+{
+    namespace
+    {
+        inline bool is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        inline bool is_safe(char c)
+        {
+            return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+        }
+
+        const char* skip_blanks_scalar(const char* first, const char* last)
+        {
+            while(first < last && is_blank(*first))
+                ++first;
+            return first;
+        }
+
+        const char* skip_blanks_back_scalar(const char* first, const char* last)
+        {
+            while(last > first && is_blank(last[-1]))
+                --last;
+            return last;
+        }
+
+        void safe_chars_scalar(const char* first, const char* last, char* out)
+        {
+            for(; first < last; ++first, ++out)
+                *out = is_safe(*first) ? *first : '_';
+        }
+
+#ifdef MPARSERS_HAVE_X86_SIMD
+        MPARSERS_TARGET("sse2")
+        inline unsigned blank_mask_sse2(const char* p)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')))
+                                           , _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+            return (unsigned)_mm_movemask_epi8(m);
+        }
+
+        MPARSERS_TARGET("sse2")
+        const char* skip_blanks_sse2(const char* first, const char* last)
+        {
+            for(; first + 16 <= last; first += 16)
+            {
+                const unsigned kept = ~blank_mask_sse2(first) & 0xffff;
+                if(kept)
+                    return first + __builtin_ctz(kept);
+            }
+            return skip_blanks_scalar(first, last);
+        }
+
+        MPARSERS_TARGET("sse2")
+        const char* skip_blanks_back_sse2(const char* first, const char* last)
+        {
+            for(; last - 16 >= first; last -= 16)
+            {
+                const unsigned kept = ~blank_mask_sse2(last - 16) & 0xffff;
+                if(kept)
+                    return last - 16 + (32 - __builtin_clz(kept));
+            }
+            return skip_blanks_back_scalar(first, last);
+        }
+
+        /* bytes of v in [lo, hi], lo and hi being ASCII: bytes from 0x80 are negative, so never in range */
+        MPARSERS_TARGET("sse2")
+        inline __m128i in_range_sse2(__m128i v, char lo, char hi)
+        {
+            return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+        }
+
+        MPARSERS_TARGET("sse2")
+        void safe_chars_sse2(const char* first, const char* last, char* out)
+        {
+            for(; first + 16 <= last; first += 16, out += 16)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const __m128i safe = _mm_or_si128(in_range_sse2(v, '0', '9')
+                                                  , in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'));
+                const __m128i res = _mm_or_si128(_mm_and_si128(safe, v), _mm_andnot_si128(safe, _mm_set1_epi8('_')));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), res);
+            }
+            safe_chars_scalar(first, last, out);
+        }
+
+        MPARSERS_TARGET("avx2")
+        inline uint32_t blank_mask_avx2(const char* p)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))
+                                                              , _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')))
+                                              , _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))
+                                                              , _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+            return (uint32_t)_mm256_movemask_epi8(m);
+        }
+
+        MPARSERS_TARGET("avx2")
+        const char* skip_blanks_avx2(const char* first, const char* last)
+        {
+            for(; first + 32 <= last; first += 32)
+            {
+                const uint32_t kept = ~blank_mask_avx2(first);
+                if(kept)
+                    return first + __builtin_ctz(kept);
+            }
+            /* not the SSE2 kernel: legacy SSE code right after AVX code pays a state transition */
+            return skip_blanks_scalar(first, last);
+        }
+
+        MPARSERS_TARGET("avx2")
+        const char* skip_blanks_back_avx2(const char* first, const char* last)
+        {
+            for(; last - 32 >= first; last -= 32)
+            {
+                const uint32_t kept = ~blank_mask_avx2(last - 32);
+                if(kept)
+                    return last - 32 + (32 - __builtin_clz(kept));
+            }
+            return skip_blanks_back_scalar(first, last);
+        }
+
+        MPARSERS_TARGET("avx2")
+        inline __m256i in_range_avx2(__m256i v, char lo, char hi)
+        {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1))
+                                    , _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+        }
+
+        MPARSERS_TARGET("avx2")
+        void safe_chars_avx2(const char* first, const char* last, char* out)
+        {
+            for(; first + 32 <= last; first += 32, out += 32)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const __m256i safe = _mm256_or_si256(in_range_avx2(v, '0', '9')
+                                                     , in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_blendv_epi8(_mm256_set1_epi8('_'), v, safe));
+            }
+            safe_chars_scalar(first, last, out);
+        }
+#endif
+
+        const char* skip_blanks(const char* first, const char* last)
+        {
+#ifdef MPARSERS_HAVE_X86_SIMD
+            if(last - first >= 16)
+            {
+                switch(simd_level())
+                {
+                    case SIMD_AVX2: return last - first >= 32 ? skip_blanks_avx2(first, last)
+                                                              : skip_blanks_sse2(first, last);
+                    case SIMD_SSE2: return skip_blanks_sse2(first, last);
+                    case SIMD_SCALAR: break;
+                    default: break;
+                }
+            }
+#endif
+            return skip_blanks_scalar(first, last);
+        }
+
+        const char* skip_blanks_back(const char* first, const char* last)
+        {
+#ifdef MPARSERS_HAVE_X86_SIMD
+            if(last - first >= 16)
+            {
+                switch(simd_level())
+                {
+                    case SIMD_AVX2: return last - first >= 32 ? skip_blanks_back_avx2(first, last)
+                                                              : skip_blanks_back_sse2(first, last);
+                    case SIMD_SSE2: return skip_blanks_back_sse2(first, last);
+                    case SIMD_SCALAR: break;
+                    default: break;
+                }
+            }
+#endif
+            return skip_blanks_back_scalar(first, last);
+        }
+    } /* namespace */
+
+    std::string build_filename(const std::string& str)
+    {
+        std::string result = str;
+        build_filename(result, &result[0]);
+        return result;
+    }
+
+    void build_filename(std::string_view str, char* out)
+    {
+        const char* first = str.data();
+        const char* last = first + str.size();
+#ifdef MPARSERS_HAVE_X86_SIMD
+        if(str.size() >= 16)
+        {
+            switch(simd_level())
+            {
+                case SIMD_AVX2:
+                    if(str.size() >= 32)
+                        safe_chars_avx2(first, last, out);
+                    else
+                        safe_chars_sse2(first, last, out);
+                    return;
+                case SIMD_SSE2: safe_chars_sse2(first, last, out); return;
+                case SIMD_SCALAR: break;
+                default: break;
+            }
+        }
+#endif
+        safe_chars_scalar(first, last, out);
+    }
+    std::vector<std::string> split(const std::string &str, char delimiter)
+    {
+        std::vector<std::string> items;
+        std::vector<uint32_t> bounds;
+        const char* first = str.data();
+        const char* last = first + str.size();
+        const char* stop = scan_fields(first, last, scan_set_t{delimiter, delimiter, delimiter}, bounds);
+        items.reserve(bounds.size() + 1);
+        for_each_field(first, stop, bounds, [&items](const char* b, const char* e)
+        {
+            items.emplace_back(b, e - b);
+        });
+        return items;
+    }
+
+    std::string ignore_comment(const std::string& str, char comment_char)
+    {
+        return str.substr(0, str.find(comment_char));
+    }
+
+    char* strtrim(char* s)
+    {
+        if(!s)  return nullptr;
+        const std::string_view trimmed = trim_view(s);
+        char* res = s + (trimmed.data() - s);
+        res[trimmed.size()] = 0;
+        return res;
+    }
+
+    std::string stdstrim(const std::string& str)
+    {
+        /* stop at the first null character, as the C string version did */
+        return std::string(trim_view(std::string_view(str.c_str())));
+    }
+
+    std::string_view trim_view(std::string_view str)
+    {
+        const char* first = skip_blanks(str.data(), str.data() + str.size());
+        const char* last = skip_blanks_back(first, str.data() + str.size());
+        return std::string_view(first, last - first);
+    }
+
+    size_t split_view(std::string_view str, char delimiter, std::string_view* parts, size_t max_parts)
+    {
+        size_t count = 0;
+        for(std::string_view part : split_view(str, delimiter))
+        {
+            if(count < max_parts)
+                parts[count] = part;
+            ++count;
+        }
+        return count;
+    }
+
+    std::string splitpath(const std::string& filename)
+    {
+        return std::string(splitpath_view(filename));
+    }
+
+    std::string_view splitpath_view(std::string_view filename)
+    {
+        const size_t last = filename.find_last_of("/\\");
+        if(last == std::string_view::npos)
+            return std::string_view();
+        if(last == filename.size()-1)
+            return filename;
+        return filename.substr(0,last);
+    }
+
+    std::string splitext(const std::string& filename)
+    {
+        return std::string(splitext_view(filename));
+    }
+
+    std::string_view splitext_view(std::string_view filename)
+    {
+        if(!filename.empty() && filename.back() == '.')
+            filename.remove_suffix(1);
+        return filename.substr(filename.find_last_of('.') + 1);
+    }
+} /*namespace mparsers*/
+
@@ -0,0 +1,284 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <set>
+#include <parsers/opt_watcher.h>
+
+#ifdef __linux__
+#define MPARSERS_HAVE_INOTIFY
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace mparsers;
+
+static bool read_file(const std::string& fn, std::string& content)
+{
+    std::ifstream ifs(fn, std::ifstream::in | std::ifstream::binary);
+    if(!ifs.good())
+        return false;
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    content = oss.str();
+    return true;
+}
+
+static long long modification_time(const std::string& fn)
+{
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(fn, ec);
+    return ec ? -1 : (long long)t.time_since_epoch().count();
+}
+
+/* directory and name used to match inotify events to a watched file */
+static std::string directory_of(const std::string& fn)
+{
+    std::string dir = std::filesystem::path(fn).parent_path().string();
+    return dir.empty() ? "." : dir;
+}
+
+static std::string name_of(const std::string& fn)
+{
+    return std::filesystem::path(fn).filename().string();
+}
+
+opt_watcher_t::opt_watcher_t(opt_parser_t& p):
+      parser(p)
+    , files()
+    , directories()
+    , changed()
+    , removed()
+    , notify_fd(-1)
+{
+#ifdef MPARSERS_HAVE_INOTIFY
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+opt_watcher_t::~opt_watcher_t()
+{
+#ifdef MPARSERS_HAVE_INOTIFY
+    if(notify_fd >= 0)
+        close(notify_fd);
+#endif
+}
+
+bool opt_watcher_t::watch(const std::string& fn)
+{
+    std::string content;
+    if(!read_file(fn, content))
+        return false;
+
+#ifdef MPARSERS_HAVE_INOTIFY
+    if(notify_fd >= 0)
+    {
+        const std::string dir = directory_of(fn);
+        int wd = inotify_add_watch(notify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(wd >= 0)
+            directories[wd] = dir;
+    }
+#endif
+    file_state_t& state = files[fn];
+    state.mtime = modification_time(fn);
+    apply(state, std::move(content));
+    return true;
+}
+
+void opt_watcher_t::unwatch(const std::string& fn)
+{
+    files.erase(fn);
+#ifdef MPARSERS_HAVE_INOTIFY
+    const std::string dir = directory_of(fn);
+    for(auto it=files.begin(); it != files.end(); ++it)
+        if(directory_of(it->first) == dir)
+            return;
+    for(auto it=directories.begin(); it != directories.end(); ++it)
+    {
+        if(it->second != dir)
+            continue;
+        inotify_rm_watch(notify_fd, it->first);
+        directories.erase(it);
+        return;
+    }
+#endif
+}
+
+int opt_watcher_t::poll(int timeout_ms)
+{
+    std::set<std::string> to_reload;
+#ifdef MPARSERS_HAVE_INOTIFY
+    if(notify_fd >= 0)
+    {
+        struct pollfd pfd = {notify_fd, POLLIN, 0};
+        if(::poll(&pfd, 1, timeout_ms) <= 0)
+            return 0;
+
+        alignas(struct inotify_event) char events[16 * 1024];
+        ssize_t len;
+        while((len = read(notify_fd, events, sizeof(events))) > 0)
+        {
+            for(char* ptr = events; ptr < events + len; )
+            {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(ptr);
+                ptr += sizeof(struct inotify_event) + ev->len;
+                auto dir = directories.find(ev->wd);
+                if(dir == directories.end() || !ev->len)
+                    continue;
+                for(auto it=files.begin(); it != files.end(); ++it)
+                    if(name_of(it->first) == ev->name && directory_of(it->first) == dir->second)
+                        to_reload.insert(it->first);
+            }
+        }
+    }
+    else
+#endif
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+        for(;;)
+        {
+            for(auto it=files.begin(); it != files.end(); ++it)
+                if(modification_time(it->first) != it->second.mtime)
+                    to_reload.insert(it->first);
+            if(!to_reload.empty() || (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline))
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    int reloaded = 0;
+    for(auto it=to_reload.begin(); it != to_reload.end(); ++it)
+        reloaded += reload(*it);
+    return reloaded;
+}
+
+bool opt_watcher_t::reload(const std::string& fn)
+{
+    auto found = files.find(fn);
+    if(found == files.end())
+        return false;
+    std::string content;
+    if(!read_file(fn, content))
+        return false;
+    found->second.mtime = modification_time(fn);
+    apply(found->second, std::move(content));
+    return true;
+}
+
+void opt_watcher_t::tokenize_lines(const std::string& content, size_t first, size_t last, std::vector<line_t>& lines)
+{
+    std::vector<char> buffer;
+    while(first < last)
+    {
+        size_t eol = content.find('\n', first);
+        size_t next = (eol == std::string::npos || eol >= last) ? last : eol + 1;
+        line_t line = {first, next - first, false, false, std::string(), std::string()};
+
+        buffer.assign(content.begin() + first, content.begin() + (eol < next ? eol : next));
+        buffer.push_back(0);
+        char* command;
+        char* value;
+        if(opt_parser_t::tokenize(buffer.data(), command, value))
+        {
+            line.assigns = true;
+            line.command = command;
+            line.has_value = value != nullptr;
+            if(value)
+                line.value = value;
+        }
+        lines.push_back(std::move(line));
+        first = next;
+    }
+}
+
+void opt_watcher_t::apply(file_state_t& state, std::string&& content)
+{
+    const std::string& old = state.content;
+
+    /* modified byte range: everything between the common prefix and the common suffix */
+    const size_t common = std::min(old.size(), content.size());
+    size_t prefix = 0;
+    while(prefix < common && old[prefix] == content[prefix])
+        ++prefix;
+    size_t suffix = 0;
+    while(suffix < common - prefix && old[old.size() - 1 - suffix] == content[content.size() - 1 - suffix])
+        ++suffix;
+    const size_t old_changed_end = old.size() - suffix;
+    const long long delta = (long long)content.size() - (long long)old.size();
+
+    /* lines ended inside the prefix, or starting after a suffix end of line, are kept */
+    std::vector<line_t> lines;
+    size_t kept_head = 0;
+    while(kept_head < state.lines.size())
+    {
+        const size_t end = state.lines[kept_head].offset + state.lines[kept_head].length;
+        if(end > prefix || old[end - 1] != '\n')
+            break;
+        ++kept_head;
+    }
+    size_t kept_tail = kept_head;
+    while(kept_tail < state.lines.size() && state.lines[kept_tail].offset <= old_changed_end)
+        ++kept_tail;
+
+    lines.reserve(state.lines.size() + 16);
+    std::move(state.lines.begin(), state.lines.begin() + kept_head, std::back_inserter(lines));
+    const size_t first = kept_head ? lines.back().offset + lines.back().length : 0;
+    const size_t last = kept_tail < state.lines.size() ? state.lines[kept_tail].offset + delta : content.size();
+    tokenize_lines(content, first, last, lines);
+    for(size_t it=kept_tail; it < state.lines.size(); ++it)
+    {
+        lines.push_back(std::move(state.lines[it]));
+        lines.back().offset += delta;
+    }
+
+    /* last value of each command */
+    std::unordered_map<std::string, value_t> values;
+    for(size_t it=0; it < lines.size(); ++it)
+    {
+        if(!lines[it].assigns)
+            continue;
+        value_t& v = values[lines[it].command];
+        v.has_value = lines[it].has_value;
+        v.value = lines[it].value;
+        v.line = it + 1;
+    }
+
+    /* added or changed commands, notified in line order */
+    std::vector<std::pair<int, const std::string*>> updates;
+    for(auto it=values.begin(); it != values.end(); ++it)
+    {
+        auto before = state.values.find(it->first);
+        if(before != state.values.end() && before->second.has_value == it->second.has_value
+           && before->second.value == it->second.value)
+            continue;
+        updates.emplace_back(it->second.line, &it->first);
+    }
+    std::sort(updates.begin(), updates.end());
+
+    std::vector<char> buffer;
+    for(auto it=updates.begin(); it != updates.end(); ++it)
+    {
+        const value_t& now = values[*it->second];
+        auto before = state.values.find(*it->second);
+        if(before != state.values.end() && changed)
+            changed(*it->second, before->second.has_value ? before->second.value.c_str() : nullptr
+                    , now.has_value ? now.value.c_str() : nullptr, now.line);
+        buffer.assign(now.value.begin(), now.value.end());
+        buffer.push_back(0);
+        parser.dispatch(*it->second, now.has_value ? buffer.data() : nullptr, now.line);
+    }
+
+    if(removed)
+    {
+        for(auto it=state.values.begin(); it != state.values.end(); ++it)
+            if(!values.count(it->first))
+                removed(it->first, it->second.has_value ? it->second.value.c_str() : nullptr);
+    }
+
+    state.content = std::move(content);
+    state.lines = std::move(lines);
+    state.values = std::move(values);
+}
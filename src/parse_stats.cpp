@@ -0,0 +1,38 @@
+#include <sstream>
+#include <parsers/parse_stats.h>
+
+using namespace mparsers;
+
+parse_stats_t& parse_stats_t::operator+=(const parse_stats_t& o)
+{
+    bytes_read += o.bytes_read;
+    lines += o.lines;
+    rows += o.rows;
+    rejected_rows += o.rejected_rows;
+    comment_lines += o.comment_lines;
+    empty_lines += o.empty_lines;
+    unknown_commands += o.unknown_commands;
+    io_ns += o.io_ns;
+    scan_ns += o.scan_ns;
+    materialize_ns += o.materialize_ns;
+    callback_ns += o.callback_ns;
+    return *this;
+}
+
+std::string parse_stats_t::to_json() const
+{
+    std::ostringstream oss;
+    oss << "{\"bytes_read\": " << bytes_read
+        << ", \"lines\": " << lines
+        << ", \"rows\": " << rows
+        << ", \"rejected_rows\": " << rejected_rows
+        << ", \"comment_lines\": " << comment_lines
+        << ", \"empty_lines\": " << empty_lines
+        << ", \"unknown_commands\": " << unknown_commands
+        << ", \"io_ns\": " << io_ns
+        << ", \"scan_ns\": " << scan_ns
+        << ", \"materialize_ns\": " << materialize_ns
+        << ", \"callback_ns\": " << callback_ns
+        << "}";
+    return oss.str();
+}
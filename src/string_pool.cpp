@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <parsers/string_pool.h>
+
+using namespace mparsers;
+
+const uint32_t string_pool_t::npos;
+const size_t string_pool_t::block_size;
+
+string_pool_t::string_pool_t():
+      __blocks()
+    , __used(0)
+    , __capacity(0)
+    , __slots(16, 0)
+    , __hashes()
+    , __values()
+{}
+
+uint32_t string_pool_t::intern(std::string_view value)
+{
+    const size_t hash = std::hash<std::string_view>()(value);
+    size_t it = slot(value, hash);
+    if(__slots[it])
+        return __slots[it] - 1;
+
+    if(__capacity - __used < value.size() || __blocks.empty())
+    {
+        __capacity = std::max(block_size, value.size());
+        __blocks.emplace_back(new char[__capacity]);
+        __used = 0;
+    }
+    char* stored = __blocks.back().get() + __used;
+    memcpy(stored, value.data(), value.size());
+    __used += value.size();
+
+    const uint32_t id = (uint32_t)__values.size();
+    __values.emplace_back(stored, value.size());
+    __hashes.push_back(hash);
+    __slots[it] = id + 1;
+    if(__values.size() * 2 > __slots.size())
+        grow();
+    return id;
+}
+
+uint32_t string_pool_t::find(std::string_view value) const
+{
+    const size_t it = slot(value, std::hash<std::string_view>()(value));
+    return __slots[it] ? __slots[it] - 1 : npos;
+}
+
+void string_pool_t::clear()
+{
+    __blocks.clear();
+    __used = 0;
+    __capacity = 0;
+    __slots.assign(16, 0);
+    __hashes.clear();
+    __values.clear();
+}
+
+void string_pool_t::grow()
+{
+    const size_t mask = __slots.size() * 2 - 1;
+    __slots.assign(mask + 1, 0);
+    for(uint32_t id=0; id < __values.size(); ++id)
+    {
+        size_t it = __hashes[id] & mask;
+        while(__slots[it])
+            it = (it + 1) & mask;
+        __slots[it] = id + 1;
+    }
+}
+
+void column_dictionaries_t::reset(const std::vector<int>& columns)
+{
+    __pools.clear();
+    for(int c : columns)
+    {
+        if(c < 0)
+            continue;
+        if((size_t)c >= __pools.size())
+            __pools.resize(c + 1);
+        if(!__pools[c])
+            __pools[c].reset(new string_pool_t());
+    }
+}
@@ -0,0 +1,107 @@
+#include <parsers/thread_pool.h>
+
+using namespace mparsers;
+
+/* pool and queue of the worker running on the current thread, if any */
+static thread_local const thread_pool_t* current_pool = nullptr;
+static thread_local int current_queue = -1;
+
+thread_pool_t::thread_pool_t(int threads):
+      workers()
+    , queues()
+    , lock()
+    , wakeup()
+    , idle()
+    , queued(0)
+    , running(0)
+    , next_queue(0)
+    , stopping(false)
+{
+    if(threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    if(threads <= 0)
+        threads = 1;
+    for(int it=0; it < threads; ++it)
+        queues.emplace_back(new queue_t());
+    for(int it=0; it < threads; ++it)
+        workers.emplace_back(&thread_pool_t::worker_loop, this, it);
+}
+
+thread_pool_t::~thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for(auto it=workers.begin(); it != workers.end(); ++it)
+        it->join();
+}
+
+std::future<void> thread_pool_t::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    const size_t target = current_pool == this ? current_queue : next_queue++ % queues.size();
+    /* counted before being visible: a worker popping it at once must not take queued below zero, and wait()
+     * must not see an empty pool while it is pending */
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(packaged));
+    }
+    wakeup.notify_one();
+    return result;
+}
+
+void thread_pool_t::wait()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this]{return !queued && !running;});
+}
+
+bool thread_pool_t::pop_task(int self, std::packaged_task<void()>& task)
+{
+    const int count = queues.size();
+    for(int it=0; it < count; ++it)
+    {
+        queue_t& queue = *queues[(self + it) % count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if(queue.tasks.empty())
+            continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        running++;
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void thread_pool_t::worker_loop(int self)
+{
+    current_pool = this;
+    current_queue = self;
+    for(;;)
+    {
+        std::packaged_task<void()> task;
+        if(pop_task(self, task))
+        {
+            task();
+            running--;
+            {
+                /* a waiter checks running under the lock: it can not miss this notification */
+                std::lock_guard<std::mutex> guard(lock);
+            }
+            idle.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        wakeup.wait(guard, [this]{return stopping || queued;});
+        if(stopping && !queued)
+            return;
+    }
+}
@@ -1,97 +1,255 @@
-#include <fstream>
-#include <cstring>
-#include <parsers/mstring_utils.h>
-#include <parsers/var_assign_parser.h>
-
-using namespace mparsers;
-void opt_parser_t::add_cmd_parser(const std::string& cmd, void* ud
-                        ,const std::function<bool(const std::string& cb, char*,void*,int)>&cb)
-{
-    opt_parser_t::command_parser_t cp;
-    cp.command = cmd;
-    cp.callback = cb;
-    cp.user_data = ud;
-    commands.push_back(cp);
-}
-
-void opt_parser_t::set_unexpected_cmd_handler(void*ud
-                , const std::function<bool(const std::string&,char*,void*,int)>& cb)
-{
-    unknown.command="dummy";
-    unknown.user_data=ud;
-    unknown.callback = cb;
-}
-
-bool opt_parser_t::__user_value_parser(const std::string& _command,char* value,bool& interrupt)
-{
-    for(auto it=commands.begin(); it != commands.end(); ++it)
-    {
-        if( it->command != _command)
-            continue;
-
-        if(it->callback)
-            interrupt=it->callback(_command, value, it->user_data,lineno);
-        return true;
-    }
-
-    if(unknown.callback)
-        interrupt = unknown.callback(_command,value, unknown.user_data,lineno);
-    return false;
-}
-
-bool opt_parser_t::parse(std::istream& streamin)
-{
-    char curent_line[1024];
-    int errors = 0;
-    lineno = 0;
-    while(streamin.good())
-    {
-        lineno++;
-        streamin.getline(curent_line,sizeof(curent_line));
-        bool interrupt=false;
-        errors += parse_line(curent_line,interrupt);
-        if(interrupt)
-            return false;
-    }
-    return true;
-}
-
-bool opt_parser_t::parse(const std::string& fn)
-{
-    std::ifstream ifs;
-    ifs.open(fn,std::ifstream::in);
-    bool result=false;
-    if(ifs.good())
-        result = parse(ifs);
-
-    ifs.close();
-    return result;
-}
-
-bool opt_parser_t::parse_line(char* line, bool& interrupt)
-{
-    if(!line)
-        return false;
-    if(*line == '#' || *line ==';')
-        return false;
-
-    char* useful = strtok(line,"#;");
-    if(!useful)
-        return false;
-
-    char* command_untrimed = strtok(useful,"=");
-    if(! command_untrimed)
-        return false;
-    char* _command;
-
-
-    _command = strtrim(command_untrimed);
-    if(!_command || !*_command)
-        return false;
-
-    char* value = strtok(nullptr,"#;");
-
-    __user_value_parser(_command,value, interrupt);
-    return true;
-}
-
+#include <cstring>
+#include <parsers/mstring_utils.h>
+#include <parsers/var_assign_parser.h>
+#include <parsers/compressed_source.h>
+
+using namespace mparsers;
+void opt_parser_t::add_cmd_parser(const std::string& cmd, void* ud
+                        ,const std::function<bool(const std::string& cb, char*,void*,int)>&cb)
+{
+    opt_parser_t::command_parser_t cp;
+    cp.command = cmd;
+    cp.callback = cb;
+    cp.user_data = ud;
+    commands.push_back(cp);
+}
+
+void opt_parser_t::set_unexpected_cmd_handler(void*ud
+                , const std::function<bool(const std::string&,char*,void*,int)>& cb)
+{
+    unknown.command="dummy";
+    unknown.user_data=ud;
+    unknown.callback = cb;
+}
+
+void opt_parser_t::set_bind_error_handler(void*ud
+                , const std::function<bool(const std::string&,char*,void*,int)>& cb)
+{
+    bind_error.command="dummy";
+    bind_error.user_data=ud;
+    bind_error.callback = cb;
+}
+
+void opt_parser_t::add_binding(const std::string& cmd, void* target, const detail::bind_names_t& names
+                               , bool (*assign)(std::string_view, void*))
+{
+    bindings.emplace_back(target, names);
+    opt_parser_t::command_parser_t cp;
+    cp.command = cmd;
+    cp.user_data = &bindings.back();
+    cp.assign = assign;
+    commands.push_back(cp);
+}
+
+void opt_parser_t::freeze()
+{
+    command_index.clear();
+    command_index.reserve(commands.size());
+    for(size_t it=0; it < commands.size(); ++it)
+        command_index.emplace(commands[it].command, it);
+    indexed_commands = commands.data();
+    indexed_count = commands.size();
+}
+
+bool opt_parser_t::__user_value_parser(std::string_view _command,char* value,int line,bool& interrupt) const
+{
+    if(static_dispatch && static_dispatch(_command, value, user_data, line, interrupt))
+        return true;
+
+    auto found = command_index.find(_command);
+    if(found != command_index.end())
+    {
+        const command_parser_t& it = commands[found->second];
+        if(it.assign)
+        {
+            if(!it.assign(value ? std::string_view(value) : std::string_view(), it.user_data) && bind_error.callback)
+                interrupt = bind_error.callback(it.command, value, bind_error.user_data, line);
+        }
+        else if(it.callback)
+            interrupt=it.callback(it.command, value, it.user_data,line);
+        return true;
+    }
+
+    if(unknown.callback)
+        interrupt = unknown.callback(std::string(_command),value, unknown.user_data,line);
+    return false;
+}
+
+bool opt_parser_t::dispatch(std::string_view _command, char* value, int line)
+{
+    if(!is_frozen())
+        freeze();
+    bool interrupt = false;
+    __user_value_parser(_command, value, line, interrupt);
+    return interrupt;
+}
+
+bool opt_parser_t::parse(std::istream& streamin)
+{
+    stream_source_t stream(streamin);
+    no_stats_t stats;
+    return parse_source(stream, stats);
+}
+
+bool opt_parser_t::parse(std::istream& streamin, collect_stats_t& stats)
+{
+    stream_source_t stream(streamin);
+    return parse_source(stream, stats);
+}
+
+bool opt_parser_t::parse(const std::string& fn)
+{
+    auto_file_source_t file;
+    if(!file.open(fn))
+        return false;
+    no_stats_t stats;
+    const bool complete = parse_source(file, stats);
+    return complete && !file.failed();
+}
+
+bool opt_parser_t::parse(const std::string& fn, collect_stats_t& stats)
+{
+    auto_file_source_t file;
+    if(!file.open(fn))
+        return false;
+    const bool complete = parse_source(file, stats);
+    return complete && !file.failed();
+}
+
+template <class stats_t>
+bool opt_parser_t::parse_source(input_source_t& source, stats_t& stats)
+{
+    timed_source_t<stats_t> timed(source, stats);
+    block_reader_t reader(timed);
+    lineno = 0;
+    if(!is_frozen())
+        freeze();
+    return parse_lines(reader, timed, lineno, stats);
+}
+
+template <class stats_t>
+bool opt_parser_t::parse_lines(block_reader_t& reader, const timed_source_t<stats_t>& timed, int& line
+                               , stats_t& stats) const
+{
+    char* curent_line;
+    size_t length;
+    int errors = 0;
+    for(;;)
+    {
+        const uint64_t since = stats.clock();
+        const uint64_t io = timed.elapsed();
+        if(!reader.next_line(curent_line, length))
+            break;
+        /* reads are io time, not scan time */
+        stats.time(&parse_stats_t::scan_ns, since + (timed.elapsed() - io));
+        line++;
+        stats.count(&parse_stats_t::lines);
+        bool interrupt=false;
+        errors += parse_line(curent_line,line,interrupt,stats);
+        if(interrupt)
+            return false;
+    }
+    return true;
+}
+
+std::vector<opt_parser_t::parse_result_t> opt_parser_t::parse_many(const std::vector<std::string>& filenames
+                                                                  , thread_pool_t& pool, bool collect_stats)
+{
+    if(!is_frozen())
+        freeze();
+
+    std::vector<parse_result_t> results(filenames.size());
+    std::vector<std::future<void>> pending;
+    pending.reserve(filenames.size());
+    for(size_t it=0; it < filenames.size(); ++it)
+    {
+        parse_result_t* result = &results[it];
+        result->filename = filenames[it];
+        pending.push_back(pool.submit([this, result, collect_stats]
+        {
+            auto_file_source_t file;
+            if(!file.open(result->filename))
+                return;
+            result->opened = true;
+            auto run = [this, result, &file](auto& stats)
+            {
+                timed_source_t<std::decay_t<decltype(stats)>> timed(file, stats);
+                block_reader_t reader(timed, 64 << 10);
+                result->interrupted = !parse_lines(reader, timed, result->lines, stats);
+            };
+            collect_stats_t stats;
+            no_stats_t none;
+            try
+            {
+                if(collect_stats)
+                    run(stats);
+                else
+                    run(none);
+            }
+            catch(...)
+            {
+                result->error = std::current_exception();
+            }
+            result->failed = file.failed();
+            result->stats = stats.snapshot();
+        }));
+    }
+    for(auto it=pending.begin(); it != pending.end(); ++it)
+        it->get();
+    return results;
+}
+
+/* split "command = value" in place, the same way strtok(line,"#;") then strtok(...,"=") did, but reentrant */
+bool opt_parser_t::tokenize(char* line, char*& command, char*& value)
+{
+    if(!line || *line == '#' || *line ==';')
+        return false;
+
+    char* comment = line + strcspn(line, "#;");
+    *comment = 0;
+
+    char* command_untrimed = line + strspn(line, "=");
+    if(!*command_untrimed)
+        return false;
+
+    char* equal = command_untrimed + strcspn(command_untrimed, "=");
+    value = nullptr;
+    if(*equal)
+    {
+        *equal = 0;
+        if(equal[1])
+            value = equal + 1;
+    }
+
+    command = strtrim(command_untrimed);
+    return command && *command;
+}
+
+template <class stats_t>
+bool opt_parser_t::parse_line(char* line, int line_number, bool& interrupt, stats_t& stats) const
+{
+    char* _command;
+    char* value;
+    /* tokenize cuts comments in place: look at the line before */
+    const char* content = stats_t::enabled ? line + strspn(line, " \t\r") : line;
+    const char kind = *content;
+    uint64_t since = stats.clock();
+    const bool has_command = tokenize(line, _command, value);
+    stats.time(&parse_stats_t::scan_ns, since);
+    if(!has_command)
+    {
+        if(kind == '#' || kind == ';')
+            stats.count(&parse_stats_t::comment_lines);
+        else if(!kind)
+            stats.count(&parse_stats_t::empty_lines);
+        else
+            stats.count(&parse_stats_t::rejected_rows);
+        return false;
+    }
+
+    since = stats.clock();
+    const bool known = __user_value_parser(_command,value,line_number,interrupt);
+    stats.time(&parse_stats_t::callback_ns, since);
+    stats.count(known ? &parse_stats_t::rows : &parse_stats_t::unknown_commands);
+    return true;
+}